@@ -0,0 +1,99 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Минимальный инструмент замеров: среднее время одной операции после прогрева
+namespace bench {
+
+    // Результаты складываются сюда, чтобы компилятор не выбросил вычисления
+    inline volatile double sink = 0.0;
+
+    // Счетчик промахов предсказания ветвлений (perf_event_open); без PMU или прав valid() == false
+    class BranchMisses {
+        int descriptor{ -1 };
+
+    public:
+        BranchMisses() {
+#if defined(__linux__)
+            perf_event_attr attributes;
+            std::memset(&attributes, 0, sizeof(attributes));
+            attributes.size = sizeof(attributes);
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+        }
+        ~BranchMisses() {
+#if defined(__linux__)
+            if (descriptor >= 0) close(descriptor);
+#endif
+        }
+        BranchMisses(const BranchMisses&) = delete;
+        BranchMisses& operator=(const BranchMisses&) = delete;
+
+        bool valid() const noexcept { return descriptor >= 0; }
+
+        void start() {
+#if defined(__linux__)
+            if (!valid()) return;
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+        }
+
+        std::uint64_t stop() {
+            std::uint64_t count = 0;
+#if defined(__linux__)
+            if (!valid()) return 0;
+            ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(descriptor, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) count = 0;
+#endif
+            return count;
+        }
+    };
+
+    template <typename Operation>
+    double measure(const char* name, std::size_t iterations, Operation&& operation) {
+        double accumulated = 0.0;
+        for (std::size_t i = 0; i < iterations / 10 + 1; ++i) {
+            accumulated += operation(i);
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            accumulated += operation(i);
+        }
+        auto endTime = std::chrono::steady_clock::now();
+        sink = accumulated;
+
+        double nanoseconds = std::chrono::duration<double, std::nano>(endTime - startTime).count() / static_cast<double>(iterations);
+        std::printf("  %-44s %12.2f ns/op\n", name, nanoseconds);
+        return nanoseconds;
+    }
+
+    // Как measure, плюс промахи предсказания ветвлений на операцию, если счетчик доступен
+    template <typename Operation>
+    double measureBranches(const char* name, std::size_t iterations, Operation&& operation) {
+        BranchMisses counter;
+        counter.start();
+        double nanoseconds = measure(name, iterations, operation);
+        std::uint64_t misses = counter.stop();
+        if (counter.valid()) {
+            std::printf("  %-44s %12.3f misses/op\n", "", static_cast<double>(misses) / static_cast<double>(iterations + iterations / 10 + 1));
+        }
+        return nanoseconds;
+    }
+
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <exception>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "async.h"
+
+// Пропускная способность и хвост задержки calculateAsync при многих отправителях:
+// тысячи корутин-сессий в полете на нескольких потоках пула против потока ОС на каждого отправителя
+
+using Clock = std::chrono::steady_clock;
+
+static const char* const kExpressions[] = {
+    "2*(3+4)-5/2", "sqrt(16)+2^10", "-(1.5+2.5)*(3-7)/4", "max(3, 7)*min(2, 9)-abs(-5)", "exp(1)*log(10)/sin(0.5)"
+};
+static constexpr std::size_t kExpressionCount = sizeof(kExpressions) / sizeof(kExpressions[0]);
+
+// Корутина без владельца: стартует сразу и уничтожает себя по завершении
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Сессия: последовательные запросы, задержка каждого - от отправки до возобновления корутины
+static Detached session(AsyncTranslator& async, std::size_t seed, std::size_t requests, std::vector<double>& latencies, std::latch& done) {
+    for (std::size_t i = 0; i < requests; ++i) {
+        const Clock::time_point sent = Clock::now();
+        bench::sink = co_await async.calculateAsync(kExpressions[(seed + i) % kExpressionCount]);
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent).count());
+    }
+    done.count_down();
+}
+
+static void report(const char* name, std::vector<double>& latencies, double seconds) {
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double fraction) { return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(fraction * latencies.size()))]; };
+    std::printf("%-44s %10.0f req/s  p50 %9.1f us  p99 %9.1f us  p99.9 %9.1f us\n",
+                name, static_cast<double>(latencies.size()) / seconds, percentile(0.50), percentile(0.99), percentile(0.999));
+}
+
+static void runCoroutines(std::size_t workers, std::size_t submitters, std::size_t sessionsPerSubmitter, std::size_t requests) {
+    AsyncTranslator async(workers);
+    const std::size_t sessions = submitters * sessionsPerSubmitter;
+    std::vector<std::vector<double>> latencies(sessions);
+    for (std::vector<double>& perSession : latencies) perSession.reserve(requests);
+    std::latch done(static_cast<std::ptrdiff_t>(sessions));
+
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < submitters; ++t) {
+        threads.emplace_back([&, t] {
+            for (std::size_t s = 0; s < sessionsPerSubmitter; ++s) {
+                const std::size_t index = t * sessionsPerSubmitter + s;
+                session(async, index, requests, latencies[index], done);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    done.wait();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const std::vector<double>& perSession : latencies) all.insert(all.end(), perSession.begin(), perSession.end());
+    char name[128];
+    std::snprintf(name, sizeof(name), "coroutines: %zu in flight, %zu workers", sessions, workers);
+    report(name, all, seconds);
+}
+
+static void runBulk(std::size_t workers, std::size_t batches, std::size_t batchSize) {
+    AsyncTranslator async(workers);
+    std::vector<std::string> batch;
+    for (std::size_t i = 0; i < batchSize; ++i) batch.push_back(kExpressions[i % kExpressionCount]);
+
+    std::vector<double> latencies;
+    const Clock::time_point start = Clock::now();
+    for (std::size_t b = 0; b < batches; ++b) {
+        const Clock::time_point sent = Clock::now();
+        std::vector<EvaluationResult> results = async.calculateAllAsync(batch).get();
+        bench::sink = results.back().value;
+        // Задержка пакета раскладывается на его элементы
+        const double perItem = std::chrono::duration<double, std::micro>(Clock::now() - sent).count();
+        latencies.insert(latencies.end(), results.size(), perItem);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    char name[128];
+    std::snprintf(name, sizeof(name), "bulk: batches of %zu, %zu workers (batch time)", batchSize, workers);
+    report(name, latencies, seconds);
+}
+
+// Для сравнения: поток ОС на каждого отправителя, синхронное вычисление.
+// Задержка здесь - только само вычисление: ожидание планировщика ОС в нее не попадает
+static void runThreadPerClient(std::size_t clients, std::size_t requests) {
+    std::vector<std::vector<double>> latencies(clients);
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            Translator translator;
+            latencies[c].reserve(requests);
+            for (std::size_t i = 0; i < requests; ++i) {
+                const Clock::time_point sent = Clock::now();
+                bench::sink = translator.calculate(kExpressions[(c + i) % kExpressionCount]);
+                latencies[c].push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent).count());
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const std::vector<double>& perClient : latencies) all.insert(all.end(), perClient.begin(), perClient.end());
+    char name[128];
+    std::snprintf(name, sizeof(name), "thread per client: %zu OS threads", clients);
+    report(name, all, seconds);
+}
+
+int main() {
+    const std::size_t workers = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    runCoroutines(workers, 4, 25, 400);
+    runCoroutines(workers, 8, 500, 20);
+    runThreadPerClient(100, 400);
+    runThreadPerClient(4000, 20);
+    runBulk(workers, 200, 1000);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "translator.h"
+#include "threaded.h"
+
+// Диспетчеризация стековой машины: switch против шитого кода, с суперинструкциями и без.
+// Профиль пар соседних инструкций корпуса показывает, какие пары стоит сливать
+
+static constexpr std::size_t kIterations = 300000;
+
+static const char* opCodeName(OpCode opCode) {
+    static const char* const names[] = { "PushConstant", "PushVariable", "Negate", "Add", "Subtract", "Multiply",
+                                         "Divide", "Power", "PowerInt", "Call", "DivideConstant" };
+    return names[static_cast<std::size_t>(opCode)];
+}
+
+int main() {
+    const std::vector<std::string> corpus = {
+        "a*x+b", "price*qty*(1-discount/100)", "(a+b)*(c-d)/(a-c)", "-x*y+z*2", "sqrt(x*x+y*y+z*z)",
+        "rate*12+fee-bonus*0.5", "((x+1)*2+y)*3-z", "a*x^2+b*x+c", "max(a, b)-min(c, d)*2", "-a*b-c*-d+e*3-f/7",
+        "total/count+margin*0.15-tax", "exp(-x*x/2)*k+1", "x0+x1*2+x2*3+x3*4+x4*5+x5*6+x6*7+x7*8"
+    };
+
+    Translator calc;
+    std::vector<Program> programs;
+    std::vector<ThreadedProgram> plainThreaded, fusedThreaded;
+    std::vector<std::vector<double>> values;
+    std::map<std::pair<OpCode, OpCode>, std::size_t> pairCounts;
+    std::size_t instructionCount = 0, fusedCount = 0;
+
+    for (const std::string& expression : corpus) {
+        programs.push_back(calc.compile(expression, OptimizerOptions{}));
+        const Program& program = programs.back();
+        plainThreaded.push_back(ThreadedEval::compile(program, false));
+        fusedThreaded.push_back(ThreadedEval::compile(program, true));
+        values.emplace_back(program.variables.size());
+        for (std::size_t slot = 0; slot < values.back().size(); ++slot) values.back()[slot] = 1.25 + 0.5 * static_cast<double>(slot);
+        for (std::size_t i = 0; i + 1 < program.code.size(); ++i) pairCounts[{ program.code[i].opCode, program.code[i + 1].opCode }]++;
+        instructionCount += program.code.size();
+        fusedCount += fusedThreaded.back().code.size() - 1;
+    }
+
+    std::vector<std::pair<std::size_t, std::pair<OpCode, OpCode>>> profile;
+    for (const auto& [pair, count] : pairCounts) profile.push_back({ count, pair });
+    std::sort(profile.rbegin(), profile.rend());
+    std::printf("Most frequent instruction pairs:\n");
+    for (std::size_t i = 0; i < std::min<std::size_t>(8, profile.size()); ++i) {
+        std::printf("  %-16s -> %-16s %zu\n", opCodeName(profile[i].second.first), opCodeName(profile[i].second.second), profile[i].first);
+    }
+    std::printf("Dispatches per corpus pass: %zu -> %zu with superinstructions\n", instructionCount, fusedCount);
+
+    if (!bench::BranchMisses().valid()) std::printf("Branch-miss counters unavailable (no PMU access); timings only\n");
+    std::printf("Computed goto: %s\n", ThreadedEval::hasComputedGoto() ? "yes" : "no (switch fallback)");
+
+    const std::size_t count = corpus.size();
+    Eval stackMachine;
+    ThreadedEval threaded;
+    bench::measureBranches("stack VM (switch over Program)", kIterations,
+                           [&](std::size_t i) { return stackMachine.evaluateProgram(programs[i % count], values[i % count].data()); });
+    bench::measureBranches("threaded code, switch", kIterations,
+                           [&](std::size_t i) { return threaded.evaluateSwitch(plainThreaded[i % count], values[i % count].data()); });
+    bench::measureBranches("threaded code, computed goto", kIterations,
+                           [&](std::size_t i) { return threaded.evaluate(plainThreaded[i % count], values[i % count].data()); });
+    bench::measureBranches("superinstructions, switch", kIterations,
+                           [&](std::size_t i) { return threaded.evaluateSwitch(fusedThreaded[i % count], values[i % count].data()); });
+    bench::measureBranches("superinstructions, computed goto", kIterations,
+                           [&](std::size_t i) { return threaded.evaluate(fusedThreaded[i % count], values[i % count].data()); });
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "parallel_eval.h"
+
+// Eval::evaluateRpn против ParallelEval на RPN в миллионы токенов
+// (длинная сумма слагаемых и произведение больших независимых сумм в скобках)
+
+static constexpr std::size_t kIterations = 5;
+
+static std::string makeSum(std::size_t terms) {
+    std::string text = "0";
+    for (std::size_t i = 0; i < terms; ++i) {
+        switch (i % 4) {
+        case 0: text += " + 1.5*2.5 - 7/3"; break;
+        case 1: text += " - (0.25 + 3*(2 - 1))*-4"; break;
+        case 2: text += " + max(1, 2)^2/7"; break;
+        default: text += " * (1 - (0.3 + 0.5)*(0.3 - 0.5))"; break;
+        }
+    }
+    return text;
+}
+
+int main() {
+    Parcer parser;
+    const std::string sum = makeSum(400000);
+    const std::string product = "(" + makeSum(100000) + ")*(" + makeSum(100000) + ")/(" + makeSum(100000) + ")";
+    for (const std::string* text : { &sum, &product }) {
+        Lexer lexer(*text);
+        const std::vector<Token> rpn = parser.toRpn(lexer);
+        std::printf("%s: %zu RPN tokens\n", text == &sum ? "flat sum" : "product of sums", rpn.size());
+
+        Eval sequential;
+        bench::measure("Eval::evaluateRpn", kIterations, [&](std::size_t) { return sequential.evaluateRpn(rpn); });
+        for (std::size_t threads : { std::size_t(1), std::size_t(2), std::size_t(4), std::size_t(8) }) {
+            ThreadPool pool(threads - 1);  // Вызывающий поток тоже работает
+            ParallelEval evaluator(pool);
+            char name[64];
+            std::snprintf(name, sizeof(name), "ParallelEval, %zu threads", threads);
+            bench::measure(name, kIterations, [&](std::size_t) { return evaluator.evaluateRpn(rpn); });
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "number_format.h"
+
+// Вывод миллиона результатов: std::ostream << double (6 значащих цифр, с потерей точности),
+// snprintf("%.17g") как в сервере и formatNumber/OutputBuffer (кратчайшая точная запись).
+// Вывод идет в /dev/null, чтобы мерить форматирование, а не диск
+
+static constexpr std::size_t kValues = 1000000;
+static constexpr std::size_t kIterations = 3;
+
+int main() {
+    std::mt19937_64 generator(1);
+    std::uniform_real_distribution<double> mantissa(-1000.0, 1000.0);
+    std::uniform_int_distribution<int> exponent(-20, 20);
+    std::vector<double> values(kValues);
+    for (double& value : values) value = mantissa(generator) * std::pow(10.0, exponent(generator));
+
+    std::FILE* null = std::fopen("/dev/null", "w");
+    if (!null) return 1;
+
+    bench::measure("std::ostringstream << double", kIterations, [&](std::size_t) {
+        std::ostringstream stream;
+        for (double value : values) stream << value << '\n';
+        std::fwrite(stream.str().data(), 1, stream.str().size(), null);
+        return static_cast<double>(stream.tellp());
+    });
+    bench::measure("snprintf %.17g", kIterations, [&](std::size_t) {
+        std::string output;
+        char number[32];
+        for (double value : values) {
+            output.append(number, static_cast<std::size_t>(std::snprintf(number, sizeof(number), "%.17g", value)));
+            output += '\n';
+        }
+        std::fwrite(output.data(), 1, output.size(), null);
+        return static_cast<double>(output.size());
+    });
+    bench::measure("OutputBuffer, shortest", kIterations, [&](std::size_t) {
+        OutputBuffer output(null);
+        for (double value : values) {
+            output.appendNumber(value);
+            output.append('\n');
+        }
+        return 0.0;
+    });
+    bench::measure("OutputBuffer, fixed 6", kIterations, [&](std::size_t) {
+        OutputBuffer output(null);
+        const NumberFormatOptions fixed{ NumberFormat::Fixed, 6 };
+        for (double value : values) {
+            output.appendNumber(value, fixed);
+            output.append('\n');
+        }
+        return 0.0;
+    });
+
+    // Проверка: кратчайшая запись читается обратно в те же биты
+    std::size_t mismatches = 0;
+    char buffer[kMaxFormattedNumber];
+    for (double value : values) {
+        buffer[formatNumber(value, buffer)] = '\0';
+        const double parsed = std::strtod(buffer, nullptr);
+        mismatches += std::memcmp(&parsed, &value, sizeof(value)) != 0;
+    }
+    std::printf("round-trip mismatches: %zu of %zu\n", mismatches, values.size());
+    std::fclose(null);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "translator.h"
+
+// Скалярная и столбцовая пропускная способность встроенных функций
+
+static constexpr std::size_t kRows = 4096;
+static constexpr std::size_t kScalarIterations = 400000;
+static constexpr std::size_t kBatchIterations = 400;
+
+int main() {
+    std::vector<double> xs(kRows), ys(kRows), results(kRows);
+    for (std::size_t i = 0; i < kRows; ++i) {
+        xs[i] = static_cast<double>(i) * 0.001 + 0.25;
+        ys[i] = static_cast<double>(i % 13) * 0.1 + 0.5;
+    }
+
+    const char* expressions[] = {
+        "sqrt(x)", "exp(x)", "log(x)", "pow(x, y)", "sin(x)", "cos(x)", "min(x, y)", "max(x, y)", "abs(x)"
+    };
+
+    Translator calc;
+    std::vector<double> arguments(2);
+    for (const char* expression : expressions) {
+        Program program = calc.compile(expression);
+        std::vector<const double*> columns;
+        for (const std::string& name : program.variables) columns.push_back(name == "x" ? xs.data() : ys.data());
+
+        std::printf("%s\n", expression);
+        bench::measure("scalar (per row)", kScalarIterations, [&](std::size_t i) {
+            std::size_t row = i % kRows;
+            for (std::size_t slot = 0; slot < columns.size(); ++slot) arguments[slot] = columns[slot][row];
+            return calc.calculate(program, arguments);
+        });
+        double batchNs = bench::measure("batch (4096 rows, per call)", kBatchIterations, [&](std::size_t) {
+            calc.calculateBatch(program, columns, kRows, results.data());
+            return results[kRows - 1];
+        });
+        std::printf("  %-44s %12.2f ns/row\n", "batch (per row)", batchNs / kRows);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "kernel.h"
+#include "translator.h"
+
+// Ядра из шаблонов против интерпретатора на одинаковых формулах.
+// Для интерпретатора значения переменных подставляются в текст заранее:
+// "calculate" включает разбор, "evaluateRpn" - только вычисление готового RPN.
+
+static constexpr std::size_t kInputCount = 1024;
+static constexpr std::size_t kIterations = 200000;
+
+static std::string number(double value) {
+    return "(" + std::to_string(value) + ")";
+}
+
+template <typename KernelType, typename Substitute>
+static void compare(const char* title, const std::vector<std::vector<double>>& inputs, Substitute substitute) {
+    std::printf("%s\n", title);
+
+    std::vector<std::string> texts;
+    std::vector<std::vector<Token>> programs;
+    Lexer tokenizer;
+    Parcer converter;
+    for (const auto& values : inputs) {
+        texts.push_back(substitute(values));
+        tokenizer.setInput(texts.back());
+        programs.push_back(converter.toRpn(tokenizer));
+    }
+
+    Translator calc;
+    Eval evaluator;
+    KernelType kernel;
+
+    bench::measure("Translator::calculate", kIterations, [&](std::size_t i) {
+        return calc.calculate(texts[i % kInputCount]);
+    });
+    bench::measure("Eval::evaluateRpn (pre-parsed)", kIterations, [&](std::size_t i) {
+        return evaluator.evaluateRpn(programs[i % kInputCount]);
+    });
+    bench::measure("Kernel (expression template)", kIterations, [&](std::size_t i) {
+        return kernel(inputs[i % kInputCount].data());
+    });
+}
+
+int main() {
+    std::vector<std::vector<double>> single, triple;
+    for (std::size_t i = 0; i < kInputCount; ++i) {
+        double x = static_cast<double>(i) * 0.01 - 5.0;
+        single.push_back({ x });
+        triple.push_back({ x, x * 0.5 + 1.0, static_cast<double>(i % 7) });
+    }
+
+    compare<Kernel<"3*x*x*x + 2*x*x - 5*x + 7">>("polynomial: 3*x*x*x + 2*x*x - 5*x + 7", single,
+        [](const std::vector<double>& v) {
+            std::string x = number(v[0]);
+            return "3*" + x + "*" + x + "*" + x + " + 2*" + x + "*" + x + " - 5*" + x + " + 7";
+        });
+
+    compare<Kernel<"(a + b) * (a - b) / (c + 1)">>("ratio: (a + b) * (a - b) / (c + 1)", triple,
+        [](const std::vector<double>& v) {
+            return "(" + number(v[0]) + " + " + number(v[1]) + ") * (" + number(v[0]) + " - " + number(v[1]) + ") / ("
+                + number(v[2]) + " + 1)";
+        });
+
+    return 0;
+}
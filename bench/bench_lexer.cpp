@@ -0,0 +1,84 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "lexer.h"
+#include "reference_lexer.h"
+#include "parser.h"
+#include "parallel_lexer.h"
+
+// Табличный Lexer против прежнего лексера на цепочке сравнений: полный проход по строке.
+// Отдельно - разбор всей строки в TokenBuffer, полный путь до RPN
+// и ParallelLexer на одном выражении в десятки мегабайт
+
+static constexpr std::size_t kIterations = 20000;
+
+template <typename LexerType>
+static double drainTokens(LexerType& lexer, const std::string& text) {
+    lexer.setInput(text);
+    double checksum = 0.0;
+    for (Token token = lexer.getNextToken(); token.type != TokenType::End; token = lexer.getNextToken()) {
+        checksum += token.numericValue + static_cast<double>(token.content.size());
+    }
+    return checksum;
+}
+
+static std::string repeat(const std::string& piece, std::size_t count) {
+    std::string text;
+    for (std::size_t i = 0; i < count; ++i) text += piece;
+    return text;
+}
+
+int main() {
+    struct Corpus {
+        const char* name;
+        std::string text;
+    };
+    const std::vector<Corpus> corpora = {
+        { "short formulas", repeat("2*(3+4)-5/2+", 100) + "1" },
+        { "numbers", repeat("1.25e-3*314159.26535+0.5/7-", 100) + "1" },
+        { "identifiers and calls", repeat("max(alpha_1, beta)*sqrt(gamma_long_name)-", 100) + "x" },
+        { "spaced operators", repeat("a   +   b   *   ( c   -   d )   /   ", 100) + "e" },
+    };
+
+    Lexer table;
+    ReferenceLexer reference;
+    TokenBuffer tokens;
+    Parcer parser;
+    for (const Corpus& corpus : corpora) {
+        std::printf("%s (%zu bytes)\n", corpus.name, corpus.text.size());
+        double tableNs = bench::measure("table-driven Lexer", kIterations, [&](std::size_t) { return drainTokens(table, corpus.text); });
+        double referenceNs = bench::measure("reference (comparison chain)", kIterations, [&](std::size_t) { return drainTokens(reference, corpus.text); });
+        std::printf("  %-44s %12.2f ns/byte vs %.2f ns/byte\n", "per byte", tableNs / corpus.text.size(), referenceNs / corpus.text.size());
+        bench::measure("tokenizeAll into TokenBuffer", kIterations, [&](std::size_t) {
+            table.setInput(corpus.text);
+            table.tokenizeAll(tokens);
+            return static_cast<double>(tokens.size());
+        });
+        bench::measure("tokenizeAll + toRpn", kIterations, [&](std::size_t) {
+            table.setInput(corpus.text);
+            return static_cast<double>(parser.toRpn(table).size());
+        });
+    }
+
+    std::string large = "0";
+    while (large.size() < (std::size_t(64) << 20)) large += " - 1.25e-3*alpha_1/-(beta+7)^2";
+    std::printf("single expression (%zu MB)\n", large.size() >> 20);
+    bench::measure("Lexer::tokenizeAll", 3, [&](std::size_t) {
+        table.setInput(large);
+        table.tokenizeAll(tokens);
+        return static_cast<double>(tokens.size());
+    });
+    for (std::size_t threads : { std::size_t(1), std::size_t(2), std::size_t(4), std::size_t(8) }) {
+        ThreadPool pool(threads - 1);  // Вызывающий поток тоже разбирает куски
+        ParallelLexer lexer(pool);
+        char name[64];
+        std::snprintf(name, sizeof(name), "ParallelLexer, %zu threads", threads);
+        bench::measure(name, 3, [&](std::size_t) {
+            lexer.tokenizeAll(large, tokens);
+            return static_cast<double>(tokens.size());
+        });
+    }
+    return 0;
+}
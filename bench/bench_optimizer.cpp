@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "translator.h"
+
+// Длинные цепочки + и *: левоглубокое RPN против сбалансированного дерева (fast-math);
+// деление на константы против умножения на обратную величину.
+// Те же цепочки на регистровой машине - в bench_vm
+
+static constexpr std::size_t kIterations = 200000;
+
+static std::string chain(const char* separator, int count) {
+    std::string expression = "x0";
+    for (int i = 1; i < count; ++i) expression += separator + std::string("x") + std::to_string(i);
+    return expression;
+}
+
+int main() {
+    Translator calc;
+    OptimizerOptions fastMath;
+    fastMath.reassociate = true;
+
+    for (int length : { 10, 64, 256 }) {
+        for (const char* separator : { "+", "*" }) {
+            std::string expression = chain(separator, length);
+            Program plain = calc.compile(expression);
+            Program balanced = calc.compile(expression, fastMath);
+            std::vector<double> values(plain.variables.size());
+            for (std::size_t i = 0; i < values.size(); ++i) values[i] = 1.0 + static_cast<double>(i % 7) * 1e-3;
+
+            std::printf("x0%sx1%s...x%d (stack depth %zu -> %zu)\n", separator, separator, length - 1,
+                        plain.stackDepth, balanced.stackDepth);
+            bench::measure("left-deep", kIterations, [&](std::size_t) { return calc.calculate(plain, values); });
+            bench::measure("balanced (fast-math)", kIterations, [&](std::size_t) { return calc.calculate(balanced, values); });
+        }
+    }
+
+    // Деление на константы: "/100" и "/4"
+    const std::string percentages = "a/100 + b/100 + c/4 + d/100 + e/4 + f/100 + g/4 + h/100";
+    Program plain = calc.compile(percentages);
+    Program reduced = calc.compile(percentages, OptimizerOptions{});
+    OptimizerOptions reciprocal;
+    reciprocal.reciprocalDivision = true;
+    Program reciprocalOnly = calc.compile(percentages, reciprocal);
+    std::vector<double> values(plain.variables.size(), 12.5);
+    std::printf("%s\n", percentages.c_str());
+    bench::measure("divide", kIterations, [&](std::size_t) { return calc.calculate(plain, values); });
+    bench::measure("exact reciprocal + DivideConstant", kIterations, [&](std::size_t) { return calc.calculate(reduced, values); });
+    bench::measure("reciprocal (fast-math)", kIterations, [&](std::size_t) { return calc.calculate(reciprocalOnly, values); });
+    return 0;
+}
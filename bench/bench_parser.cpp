@@ -0,0 +1,43 @@
+#include <cstdio>
+#include <string>
+
+#include "bench.h"
+#include "parallel_lexer.h"
+#include "parallel_parser.h"
+
+// Parcer::toRpn против ParallelParser на одном выражении в миллионы токенов
+// (плоские суммы произведений и вложенные группы в скобках)
+
+static constexpr std::size_t kIterations = 3;
+
+static std::string makeExpression(std::size_t terms) {
+    std::string text = "0";
+    for (std::size_t i = 0; i < terms; ++i) {
+        switch (i % 4) {
+        case 0: text += " + x*2.5 - y/3"; break;
+        case 1: text += " - (a + b*(c - 1))*-d"; break;
+        case 2: text += " + max(x, y)^2/7"; break;
+        default: text += " * (1 - (z + 0.5)*(z - 0.5))"; break;
+        }
+    }
+    return text;
+}
+
+int main() {
+    const std::string text = makeExpression(400000);
+    Lexer lexer(text);
+    TokenBuffer tokens;
+    lexer.tokenizeAll(tokens);
+    std::printf("expression: %zu MB, %zu tokens\n", text.size() >> 20, tokens.size());
+
+    Parcer sequential;
+    bench::measure("Parcer::toRpn", kIterations, [&](std::size_t) { return static_cast<double>(sequential.toRpn(tokens, text).size()); });
+    for (std::size_t threads : { std::size_t(1), std::size_t(2), std::size_t(4), std::size_t(8) }) {
+        ThreadPool pool(threads - 1);  // Вызывающий поток тоже работает
+        ParallelParser parser(pool);
+        char name[64];
+        std::snprintf(name, sizeof(name), "ParallelParser, %zu threads", threads);
+        bench::measure(name, kIterations, [&](std::size_t) { return static_cast<double>(parser.toRpn(tokens, text).size()); });
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "translator.h"
+#include "program_file.h"
+
+// Старт сервиса: разбор 100 000 формул против загрузки уже скомпилированной библиотеки
+
+static constexpr std::size_t kFormulaCount = 100000;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    std::vector<std::string> formulas;
+    formulas.reserve(kFormulaCount);
+    for (std::size_t i = 0; i < kFormulaCount; ++i) {
+        std::string n = std::to_string(i);
+        formulas.push_back("price" + n + "*qty*(1-discount/100)+fee*" + n + "-sqrt(base^2+" + n + ")");
+    }
+
+    Translator calc;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Program> programs;
+    programs.reserve(kFormulaCount);
+    for (const std::string& formula : formulas) programs.push_back(calc.compile(formula, OptimizerOptions{}));
+    std::printf("  %-44s %12.2f ms\n", "parse + compile 100k formulas", millisecondsSince(start));
+
+    const std::string path = (std::filesystem::temp_directory_path() / "bench_programs.trpl").string();
+    start = std::chrono::steady_clock::now();
+    ProgramLibrary::save(path, programs);
+    std::printf("  %-44s %12.2f ms (%ju bytes)\n", "save library", millisecondsSince(start),
+                static_cast<std::uintmax_t>(std::filesystem::file_size(path)));
+
+    start = std::chrono::steady_clock::now();
+    ProgramLibrary library = ProgramLibrary::load(path);
+    std::printf("  %-44s %12.2f ms\n", "mmap + validate library", millisecondsSince(start));
+
+    std::vector<double> values(library[0].variableCount(), 1.5);
+    bench::measure("evaluate Program", 200000, [&](std::size_t i) { return calc.calculate(programs[i % kFormulaCount], values); });
+    bench::measure("evaluate ProgramView (mmap)", 200000, [&](std::size_t i) { return calc.calculate(library[i % kFormulaCount], values); });
+    std::filesystem::remove(path);
+    return 0;
+}
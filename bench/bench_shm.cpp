@@ -0,0 +1,73 @@
+#include <csignal>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "translator.h"
+#include "shm_ring.h"
+#include "server.h"
+
+// Время полного цикла "запрос - ответ" для вычислителя в другом процессе:
+// кольца в разделяемой памяти против Unix-сокета, для сравнения - вызов в своем процессе
+
+static constexpr std::size_t kIterations = 200000;
+
+int main() {
+    const std::string name = "/bench_translator_" + std::to_string(getpid());
+    const std::string socketPath = "/tmp/bench_translator_" + std::to_string(getpid()) + ".sock";
+
+    pid_t child = fork();
+    if (child == 0) {
+        // Серверный процесс: оба сервера, пока родитель не пришлет SIGTERM
+        ShmEvaluationServer shmServer(name, 1);
+        ServerOptions options;
+        options.unixPath = socketPath;
+        options.workerCount = 1;
+        EvaluationServer socketServer(options);
+        std::thread socketLoop([&] { socketServer.run(); });
+        shmServer.start();
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGTERM);
+        sigprocmask(SIG_BLOCK, &signals, nullptr);
+        int received = 0;
+        sigwait(&signals, &received);
+        shmServer.stop();
+        socketServer.stop();
+        socketLoop.join();
+        _exit(0);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    Translator local;
+    bench::measure("in-process Translator::calculate", kIterations, [&](std::size_t) { return local.calculate("2*(3+4)-5/2"); });
+
+    {
+        ShmClient client(name);
+        bench::measure("shared-memory ring round trip", kIterations, [&](std::size_t) { return client.calculate("2*(3+4)-5/2"); });
+    }
+
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", socketPath.c_str());
+    if (connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        char buffer[64];
+        bench::measure("Unix socket round trip", kIterations / 10, [&](std::size_t) {
+            static const char request[] = "2*(3+4)-5/2\n";
+            if (write(descriptor, request, sizeof(request) - 1) < 0) return 0.0;
+            ssize_t length = read(descriptor, buffer, sizeof(buffer));
+            return static_cast<double>(length);
+        });
+    }
+    close(descriptor);
+
+    kill(child, SIGTERM);
+    waitpid(child, nullptr, 0);
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "translator.h"
+#include "register_vm.h"
+
+// Стековая машина против регистровой на трех наборах выражений:
+// короткие формулы, глубоко вложенные скобки и длинные плоские суммы.
+// Отдельно - длинные цепочки + и * до и после перебалансировки (OptimizerOptions::reassociate)
+
+static constexpr std::size_t kIterations = 200000;
+
+static std::string deepExpression(int depth) {
+    std::string expression = "x";
+    for (int i = 0; i < depth; ++i) {
+        expression = "(" + expression + (i % 2 ? ")*y+" : ")/z-") + std::to_string(i + 1);
+    }
+    return expression;
+}
+
+static std::string longExpression(int terms) {
+    std::string expression = "a*x";
+    const char* operators[] = { "+", "-", "*", "+" };
+    for (int i = 1; i < terms; ++i) {
+        expression += operators[i % 4];
+        expression += (i % 3 == 0) ? "sqrt(x+" + std::to_string(i) + ")" : "b*y^2";
+    }
+    return expression;
+}
+
+static void compare(Translator& calc, const char* corpus, const std::vector<std::string>& expressions) {
+    std::vector<Program> programs;
+    std::vector<RegisterProgram> registerPrograms;
+    std::vector<std::vector<double>> values;
+    for (const std::string& expression : expressions) {
+        programs.push_back(calc.compile(expression, OptimizerOptions{}));
+        registerPrograms.push_back(RegisterCompiler::compile(programs.back()));
+        values.emplace_back(programs.back().variables.size(), 1.5);
+    }
+    const std::size_t count = expressions.size();
+    std::printf("%s (%zu expressions)\n", corpus, count);
+    bench::measure("stack VM", kIterations, [&](std::size_t i) { return calc.calculate(programs[i % count], values[i % count]); });
+    bench::measure("register VM", kIterations,
+                   [&](std::size_t i) { return calc.calculate(registerPrograms[i % count], values[i % count]); });
+}
+
+static std::string chain(const char* separator, int count) {
+    std::string expression = "x0";
+    for (int i = 1; i < count; ++i) expression += separator + std::string("x") + std::to_string(i);
+    return expression;
+}
+
+// Левоглубокая цепочка - одна длинная зависимость; сбалансированное дерево дает независимые
+// операции, которые процессор выполняет одновременно, если их не прячет диспетчеризация
+static void compareChains(Translator& calc, int length, const char* separator) {
+    OptimizerOptions fastMath;
+    fastMath.reassociate = true;
+    const std::string expression = chain(separator, length);
+    const Program plain = calc.compile(expression, OptimizerOptions{});
+    const Program balanced = calc.compile(expression, fastMath);
+    const RegisterProgram plainRegisters = RegisterCompiler::compile(plain);
+    const RegisterProgram balancedRegisters = RegisterCompiler::compile(balanced);
+    std::vector<double> values(plain.variables.size());
+    for (std::size_t i = 0; i < values.size(); ++i) values[i] = 1.0 + static_cast<double>(i % 7) * 1e-3;
+
+    std::printf("x0%sx1%s...x%d (registers %zu -> %zu)\n", separator, separator, length - 1,
+                plainRegisters.registerCount, balancedRegisters.registerCount);
+    bench::measure("stack VM, left-deep", kIterations, [&](std::size_t) { return calc.calculate(plain, values); });
+    bench::measure("stack VM, balanced", kIterations, [&](std::size_t) { return calc.calculate(balanced, values); });
+    bench::measure("register VM, left-deep", kIterations, [&](std::size_t) { return calc.calculate(plainRegisters, values); });
+    bench::measure("register VM, balanced", kIterations, [&](std::size_t) { return calc.calculate(balancedRegisters, values); });
+}
+
+int main() {
+    Translator calc;
+    compare(calc, "short", { "a*x+b", "x*x-y", "(a+b)/2", "sqrt(x*x+y*y)", "-x+3", "max(a, b)*c" });
+    compare(calc, "deep", { deepExpression(16), deepExpression(32), deepExpression(64) });
+    compare(calc, "long", { longExpression(64), longExpression(128), longExpression(256) });
+    for (int length : { 10, 64, 256 }) {
+        for (const char* separator : { "+", "*" }) compareChains(calc, length, separator);
+    }
+    return 0;
+}
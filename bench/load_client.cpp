@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Генератор нагрузки для translator_app --serve.
+//   load_client <путь сокета | tcp:порт> [соединений=4] [запросов на соединение=100000] [окно конвейера=64]
+// Каждое соединение держит в полете до "окна" запросов и меряет задержку от отправки до ответа.
+
+using Clock = std::chrono::steady_clock;
+
+static int connectTo(const std::string& target) {
+    if (target.rfind("tcp:", 0) == 0) {
+        int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(std::stoul(target.substr(4))));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return -1;
+        int enable = 1;
+        setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        return descriptor;
+    }
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, target.c_str(), sizeof(address.sun_path) - 1);
+    if (connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return -1;
+    return descriptor;
+}
+
+struct ConnectionResult {
+    std::vector<double> latenciesMicroseconds;
+    std::size_t errors{ 0 };
+    bool failed{ false };
+};
+
+static void runConnection(const std::string& target, std::size_t requests, std::size_t window, ConnectionResult& result) {
+    static const char* const expressions[] = {
+        "2*(3+4)-5/2", "sqrt(16)+2^10", "-(1.5+2.5)*(3-7)/4", "max(3, 7)*min(2, 9)-abs(-5)", "exp(1)*log(10)/sin(0.5)"
+    };
+    int descriptor = connectTo(target);
+    if (descriptor < 0) {
+        result.failed = true;
+        return;
+    }
+
+    std::vector<Clock::time_point> sentAt(requests);
+    result.latenciesMicroseconds.reserve(requests);
+    std::size_t sent = 0, received = 0;
+    std::string outgoing, incoming;
+    char buffer[64 * 1024];
+
+    while (received < requests) {
+        outgoing.clear();
+        const Clock::time_point now = Clock::now();
+        while (sent < requests && sent - received < window) {
+            outgoing += expressions[sent % (sizeof(expressions) / sizeof(expressions[0]))];
+            outgoing += '\n';
+            sentAt[sent++] = now;
+        }
+        for (std::size_t offset = 0; offset < outgoing.size();) {
+            ssize_t written = send(descriptor, outgoing.data() + offset, outgoing.size() - offset, MSG_NOSIGNAL);
+            if (written <= 0) {
+                result.failed = true;
+                close(descriptor);
+                return;
+            }
+            offset += static_cast<std::size_t>(written);
+        }
+
+        ssize_t length = recv(descriptor, buffer, sizeof(buffer), 0);
+        if (length <= 0) {
+            result.failed = true;
+            break;
+        }
+        const Clock::time_point arrived = Clock::now();
+        incoming.append(buffer, static_cast<std::size_t>(length));
+        std::size_t begin = 0;
+        for (std::size_t newline; (newline = incoming.find('\n', begin)) != std::string::npos; begin = newline + 1) {
+            if (incoming.compare(begin, 6, "Error:") == 0) result.errors++;
+            result.latenciesMicroseconds.push_back(std::chrono::duration<double, std::micro>(arrived - sentAt[received++]).count());
+        }
+        incoming.erase(0, begin);
+    }
+    close(descriptor);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <socket path | tcp:port> [connections] [requests per connection] [window]\n", argv[0]);
+        return 2;
+    }
+    const std::string target = argv[1];
+    const std::size_t connections = argc > 2 ? std::stoul(argv[2]) : 4;
+    const std::size_t requests = argc > 3 ? std::stoul(argv[3]) : 100000;
+    const std::size_t window = argc > 4 ? std::max<std::size_t>(1, std::stoul(argv[4])) : 64;
+
+    std::vector<ConnectionResult> results(connections);
+    std::vector<std::thread> threads;
+    const Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < connections; ++i) {
+        threads.emplace_back([&, i] { runConnection(target, requests, window, results[i]); });
+    }
+    for (std::thread& thread : threads) thread.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    std::size_t errors = 0, failed = 0;
+    for (const ConnectionResult& result : results) {
+        latencies.insert(latencies.end(), result.latenciesMicroseconds.begin(), result.latenciesMicroseconds.end());
+        errors += result.errors;
+        failed += result.failed ? 1 : 0;
+    }
+    if (latencies.empty()) {
+        std::fprintf(stderr, "no responses (is the server running on %s?)\n", target.c_str());
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double fraction) { return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(fraction * latencies.size()))]; };
+
+    std::printf("%zu connections x %zu requests, window %zu\n", connections, requests, window);
+    std::printf("  %-20s %12.0f req/s\n", "throughput", static_cast<double>(latencies.size()) / seconds);
+    std::printf("  %-20s %12.1f us\n", "latency p50", percentile(0.50));
+    std::printf("  %-20s %12.1f us\n", "latency p90", percentile(0.90));
+    std::printf("  %-20s %12.1f us\n", "latency p99", percentile(0.99));
+    std::printf("  %-20s %12.1f us\n", "latency p99.9", percentile(0.999));
+    std::printf("  %-20s %12zu\n", "error responses", errors);
+    if (failed) std::printf("  %-20s %12zu\n", "failed connections", failed);
+    return failed ? 1 : 0;
+}
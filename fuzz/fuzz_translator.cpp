@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "translator.h"
+
+// Поиск входов, на которых Lexer, Parcer или Eval работают непропорционально долго или берут много памяти.
+// Цель для libFuzzer (clang, -DENABLE_FUZZING=ON):
+//   fuzz_translator -max_len=4096 fuzz/corpus
+// Если время или прирост пиковой памяти выходят за бюджет "постоянная часть + порог на байт ввода",
+// процесс завершается через abort(), и libFuzzer сохраняет вход как crash-артефакт.
+// Пороги на байт задаются переменными окружения TRANSLATOR_FUZZ_NS_PER_BYTE и TRANSLATOR_FUZZ_BYTES_PER_BYTE;
+// TRANSLATOR_FUZZ_NS_PER_BYTE=0 отключает проверку времени (ctest: время на загруженной машине и в отладочной сборке не показательно).
+// Без libFuzzer собирается fuzz_replay: прогоняет файлы и каталоги из аргументов с теми же проверками
+
+namespace {
+    // Живая и пиковая память через operator new; размер блока хранится перед ним
+    std::atomic<std::size_t> liveBytes{ 0 };
+    std::atomic<std::size_t> peakBytes{ 0 };
+    constexpr std::size_t kHeader = alignof(std::max_align_t);
+
+    // Постоянная часть бюджета: короткий ввод не упирается в накладные расходы вызова и шум таймера
+    constexpr double kFixedNanos = 200000.0;
+    constexpr double kFixedBytes = 64 * 1024;
+
+    double thresholdFromEnvironment(const char* name, double fallback) {
+        const char* value = std::getenv(name);
+        return value ? std::strtod(value, nullptr) : fallback;
+    }
+
+    struct Thresholds {
+        double nanosPerByte;
+        double bytesPerByte;
+    };
+
+    const Thresholds& thresholds() {
+        static const Thresholds values{ thresholdFromEnvironment("TRANSLATOR_FUZZ_NS_PER_BYTE", 2000.0),
+                                        thresholdFromEnvironment("TRANSLATOR_FUZZ_BYTES_PER_BYTE", 512.0) };
+        return values;
+    }
+
+    struct Measurement {
+        double nanos;
+        std::size_t bytes;   // Прирост пиковой памяти относительно начала вызова
+    };
+
+    volatile double sink = 0.0;
+
+    Measurement measure(Translator& translator, const std::string& expression) {
+        const std::size_t baseline = liveBytes.load(std::memory_order_relaxed);
+        peakBytes.store(baseline, std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            sink = translator.calculate(expression);
+        }
+        catch (const std::exception&) {
+            // Ошибки разбора и вычисления - обычный исход для случайного ввода
+        }
+        const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return { nanos, peakBytes.load(std::memory_order_relaxed) - baseline };
+    }
+}
+
+void* operator new(std::size_t size) {
+    auto* block = static_cast<unsigned char*>(std::malloc(size + kHeader));
+    if (!block) throw std::bad_alloc();
+    *reinterpret_cast<std::size_t*>(block) = size;
+    const std::size_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return block + kHeader;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    auto* block = static_cast<unsigned char*>(ptr) - kHeader;
+    liveBytes.fetch_sub(*reinterpret_cast<std::size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    // Один Translator на процесс, как у потока сервера: рабочие буферы переживают вызовы
+    static Translator translator;
+    const std::string expression(reinterpret_cast<const char*>(data), size);
+    const Thresholds& limits = thresholds();
+    const bool checkTime = limits.nanosPerByte > 0.0;
+    const double timeBudget = kFixedNanos + limits.nanosPerByte * static_cast<double>(size);
+    const double memoryBudget = kFixedBytes + limits.bytesPerByte * static_cast<double>(size);
+
+    Measurement result = measure(translator, expression);
+    // Одиночный выброс (планировщик, первый доступ к страницам) не в счет: берется лучший из трех замеров
+    for (int retry = 0; checkTime && retry < 2 && result.nanos > timeBudget; ++retry) {
+        result.nanos = std::min(result.nanos, measure(translator, expression).nanos);
+    }
+    const bool slow = checkTime && result.nanos > timeBudget;
+    if (!slow && static_cast<double>(result.bytes) <= memoryBudget) return 0;
+
+    std::fprintf(stderr, "==translator-fuzz== %s input of %zu bytes: %.0f ns (%.1f ns/byte), peak +%zu bytes (%.1f bytes/byte)\n",
+                 slow ? "slow" : "memory hungry", size, result.nanos,
+                 result.nanos / static_cast<double>(std::max<std::size_t>(1, size)), result.bytes,
+                 static_cast<double>(result.bytes) / static_cast<double>(std::max<std::size_t>(1, size)));
+    std::abort();
+}
+
+#if !defined(TRANSLATOR_FUZZ_LIBFUZZER)
+// fuzz_replay <файл или каталог>...
+int main(int argc, char** argv) {
+    std::size_t inputs = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::vector<std::filesystem::path> files;
+        if (std::filesystem::is_directory(argv[i])) {
+            for (const auto& entry : std::filesystem::directory_iterator(argv[i])) {
+                if (entry.is_regular_file()) files.push_back(entry.path());
+            }
+            std::sort(files.begin(), files.end());
+        }
+        else {
+            files.emplace_back(argv[i]);
+        }
+        for (const std::filesystem::path& file : files) {
+            std::ifstream stream(file, std::ios::binary);
+            if (!stream) {
+                std::fprintf(stderr, "Cannot open %s\n", file.string().c_str());
+                return 2;
+            }
+            const std::string data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+            LLVMFuzzerTestOneInput(reinterpret_cast<const std::uint8_t*>(data.data()), data.size());
+            ++inputs;
+        }
+    }
+    std::printf("%zu inputs within %s budget\n", inputs, thresholds().nanosPerByte > 0.0 ? "time and memory" : "memory");
+    return 0;
+}
+#endif
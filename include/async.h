@@ -0,0 +1,352 @@
+#pragma once
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <semaphore>
+#include <atomic>
+#include <optional>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <thread>
+#include <cstddef>
+#include "translator.h"
+#include "thread_pool.h"
+
+// Асинхронное вычисление на C++20 корутинах. AsyncTranslator::calculateAsync ставит вычисление в очередь
+// своего пула и сразу возвращает AsyncTask: его можно ждать через co_await (корутина продолжится в потоке пула)
+// или блокирующим get(). Тысячи ожидающих корутин не держат потоков - работают только потоки пула.
+
+class OperationCancelled : public std::runtime_error {
+public:
+    OperationCancelled() : std::runtime_error("Async error: cancelled") {}
+};
+
+class CancellationToken {
+    std::shared_ptr<const std::atomic<bool>> flag;
+
+public:
+    CancellationToken() = default;
+    explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> cancelled) : flag(std::move(cancelled)) {}
+    bool cancelled() const noexcept { return flag && flag->load(std::memory_order_acquire); }
+};
+
+// Отмена влияет на вычисления, которые еще не начались
+class CancellationSource {
+    std::shared_ptr<std::atomic<bool>> flag{ std::make_shared<std::atomic<bool>>(false) };
+
+public:
+    void cancel() noexcept { flag->store(true, std::memory_order_release); }
+    bool cancelled() const noexcept { return flag->load(std::memory_order_acquire); }
+    CancellationToken token() const { return CancellationToken(flag); }
+};
+
+namespace detail {
+
+    // Общее состояние задачи: результат пишет поток пула, читает ожидающий
+    template <typename T>
+    struct AsyncState {
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done{ false };
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+
+        template <typename Setter>
+        void complete(Setter&& setter) {
+            std::coroutine_handle<> resumed;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                setter(*this);
+                done = true;
+                resumed = std::exchange(continuation, nullptr);
+            }
+            finished.notify_all();
+            if (resumed) resumed.resume();
+        }
+    };
+
+}
+
+template <typename T>
+class AsyncTask {
+    std::shared_ptr<detail::AsyncState<T>> state;
+
+    T take() {
+        if (state->error) std::rethrow_exception(state->error);
+        return std::move(*state->value);
+    }
+
+public:
+    explicit AsyncTask(std::shared_ptr<detail::AsyncState<T>> sharedState) : state(std::move(sharedState)) {}
+
+    bool ready() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->done;
+    }
+
+    // Блокирующее ожидание для кода без корутин
+    T get() {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [this] { return state->done; });
+        return take();
+    }
+
+    bool await_ready() const { return ready(); }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->done) return false;
+        state->continuation = awaiting;
+        return true;
+    }
+
+    T await_resume() { return take(); }
+};
+
+// Корутина, которая сама может ждать AsyncTask и другие Task; запускается при первом co_await
+template <typename T>
+class Task;
+
+namespace detail {
+
+    struct TaskPromiseBase {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr error;
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept {
+                std::coroutine_handle<> next = finished.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase {
+        std::optional<T> value;
+        Task<T> get_return_object();
+        void return_value(T result) { value = std::move(result); }
+        T result() {
+            if (error) std::rethrow_exception(error);
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase {
+        Task<void> get_return_object();
+        void return_void() {}
+        void result() {
+            if (error) std::rethrow_exception(error);
+        }
+    };
+
+}
+
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+public:
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() { return handle.promise().result(); }
+};
+
+namespace detail {
+
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object() { return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this)); }
+
+    inline Task<void> TaskPromise<void>::get_return_object() {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+
+    // Корутина-обертка для syncWait: по завершении отпускает семафор
+    struct SyncWaitCoroutine {
+        struct promise_type {
+            std::binary_semaphore* done{ nullptr };
+            SyncWaitCoroutine get_return_object() { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            auto final_suspend() noexcept {
+                struct Release {
+                    bool await_ready() noexcept { return false; }
+                    void await_suspend(std::coroutine_handle<promise_type> finished) noexcept { finished.promise().done->release(); }
+                    void await_resume() noexcept {}
+                };
+                return Release{};
+            }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    template <typename T>
+    SyncWaitCoroutine syncWaitBody(Task<T>& task, std::optional<T>& result, std::exception_ptr& error) {
+        try {
+            result.emplace(co_await task);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    inline SyncWaitCoroutine syncWaitBody(Task<void>& task, std::exception_ptr& error) {
+        try {
+            co_await task;
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    inline void runSyncWait(SyncWaitCoroutine waiter) {
+        std::binary_semaphore done{ 0 };
+        waiter.handle.promise().done = &done;
+        waiter.handle.resume();
+        done.acquire();
+        waiter.handle.destroy();
+    }
+
+}
+
+// Запуск корутины из обычного кода с ожиданием результата
+template <typename T>
+T syncWait(Task<T> task) {
+    std::optional<T> result;
+    std::exception_ptr error;
+    detail::runSyncWait(detail::syncWaitBody(task, result, error));
+    if (error) std::rethrow_exception(error);
+    return std::move(*result);
+}
+
+inline void syncWait(Task<void> task) {
+    std::exception_ptr error;
+    detail::runSyncWait(detail::syncWaitBody(task, error));
+    if (error) std::rethrow_exception(error);
+}
+
+class AsyncTranslator {
+    ThreadPool executor;
+
+    // Пакет делится на куски не меньше этого размера, чтобы не плодить мелкие задачи пула
+    static constexpr std::size_t kMinBulkChunk = 64;
+
+    // У каждого потока пула свой Translator
+    static Translator& threadTranslator() {
+        static thread_local Translator translator;
+        return translator;
+    }
+
+public:
+    explicit AsyncTranslator(std::size_t threadCount = std::max<std::size_t>(1, std::thread::hardware_concurrency()))
+        : executor(threadCount) {}
+
+    std::size_t threadCount() const noexcept { return executor.size(); }
+
+    AsyncTask<double> calculateAsync(std::string expression, CancellationToken token = {}) {
+        auto state = std::make_shared<detail::AsyncState<double>>();
+        executor.submit([state, expression = std::move(expression), token = std::move(token)] {
+            std::exception_ptr error;
+            double value = 0.0;
+            try {
+                if (token.cancelled()) throw OperationCancelled();
+                value = threadTranslator().calculate(expression);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            state->complete([&](detail::AsyncState<double>& target) {
+                if (error) target.error = error;
+                else target.value = value;
+            });
+        });
+        return AsyncTask<double>(std::move(state));
+    }
+
+    // Пакетная отправка: одна задача на результат, ошибки - по элементам, а не исключением
+    AsyncTask<std::vector<EvaluationResult>> calculateAllAsync(std::vector<std::string> expressions, CancellationToken token = {}) {
+        struct Bulk {
+            std::vector<std::string> expressions;
+            std::vector<EvaluationResult> results;
+            std::atomic<std::size_t> remainingChunks{ 0 };
+            CancellationToken token;
+        };
+        auto state = std::make_shared<detail::AsyncState<std::vector<EvaluationResult>>>();
+        auto bulk = std::make_shared<Bulk>();
+        bulk->results.resize(expressions.size());
+        bulk->expressions = std::move(expressions);
+        bulk->token = std::move(token);
+
+        const std::size_t count = bulk->expressions.size();
+        if (count == 0) {
+            state->complete([](auto& target) { target.value.emplace(); });
+            return AsyncTask<std::vector<EvaluationResult>>(std::move(state));
+        }
+        const std::size_t targetChunks = executor.size() * 4;
+        const std::size_t chunkSize = std::max(kMinBulkChunk, (count + targetChunks - 1) / targetChunks);
+        const std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+        bulk->remainingChunks.store(chunkCount, std::memory_order_relaxed);
+
+        for (std::size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            executor.submit([state, bulk, begin = chunk * chunkSize, end = std::min(count, (chunk + 1) * chunkSize)] {
+                Translator& translator = threadTranslator();
+                for (std::size_t i = begin; i < end; ++i) {
+                    EvaluationResult& result = bulk->results[i];
+                    if (bulk->token.cancelled()) {
+                        result.error = OperationCancelled().what();
+                        continue;
+                    }
+                    try {
+                        result.value = translator.calculate(bulk->expressions[i]);
+                    }
+                    catch (const std::exception& e) {
+                        result.error = e.what();
+                    }
+                }
+                // Последний завершившийся кусок отдает результат
+                if (bulk->remainingChunks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    state->complete([&](auto& target) { target.value.emplace(std::move(bulk->results)); });
+                }
+            });
+        }
+        return AsyncTask<std::vector<EvaluationResult>>(std::move(state));
+    }
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <exception>
+#include <cstddef>
+#include <cstdint>
+#include "translator.h"
+
+struct BatchStats {
+    std::size_t lines{ 0 };      // Сколько строк обработано
+    std::size_t distinct{ 0 };   // Сколько из них вычислено (различные строки)
+
+    // Во сколько раз меньше вычислений, чем строк
+    double dedupRatio() const noexcept {
+        return distinct == 0 ? 1.0 : static_cast<double>(lines) / static_cast<double>(distinct);
+    }
+};
+
+// Пакетное вычисление строк: каждая различная строка вычисляется один раз,
+// повторы получают сохраненный результат или ту же ошибку. Строки обрабатываются по мере поступления,
+// поэтому ответы идут в исходном порядке, а в памяти хранятся только различные строки
+class BatchEvaluator {
+    // Поиск по string_view без создания std::string для каждой строки
+    struct TextHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view text) const noexcept { return std::hash<std::string_view>{}(text); }
+    };
+
+    Translator translator;
+    std::unordered_map<std::string, std::uint32_t, TextHash, std::equal_to<>> slots;  // Строка -> номер в results
+    std::vector<EvaluationResult> results;
+    BatchStats counters;
+
+public:
+    // Ссылка действительна до следующего вызова evaluate или clear
+    const EvaluationResult& evaluate(std::string_view line) {
+        ++counters.lines;
+        auto found = slots.find(line);
+        if (found != slots.end()) return results[found->second];
+
+        EvaluationResult result;
+        try {
+            result.value = translator.calculate(std::string(line));
+        }
+        catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        slots.emplace(line, static_cast<std::uint32_t>(results.size()));
+        results.push_back(std::move(result));
+        ++counters.distinct;
+        return results.back();
+    }
+
+    const BatchStats& stats() const noexcept { return counters; }
+
+    void clear() {
+        slots.clear();
+        results.clear();
+        counters = {};
+    }
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <limits>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+
+// Код превышенного лимита (LimitExceeded::kind)
+enum class LimitKind : std::uint8_t {
+    InputBytes = 1,  // Длина строки выражения
+    Tokens,          // Число токенов без завершающего End
+    Nesting,         // Глубина скобок
+    StackDepth       // Стек операторов парсера и стек значений при вычислении
+};
+
+// Лимиты на одно выражение; по умолчанию ничего не ограничено.
+// Проверяются по ходу разбора и вычисления, отдельного прохода по вводу нет
+struct EvaluationLimits {
+    static constexpr std::size_t kUnlimited = std::numeric_limits<std::size_t>::max();
+
+    std::size_t maxInputBytes{ kUnlimited };
+    std::size_t maxTokens{ kUnlimited };
+    std::size_t maxNesting{ kUnlimited };
+    std::size_t maxStackDepth{ kUnlimited };
+
+    // Для общего серверного пути: один запрос не должен надолго занимать поток пула
+    static constexpr EvaluationLimits serverDefaults() {
+        EvaluationLimits limits;
+        limits.maxInputBytes = 1 << 20;
+        limits.maxTokens = 1 << 18;
+        limits.maxNesting = 256;
+        limits.maxStackDepth = 4096;
+        return limits;
+    }
+};
+
+class LimitExceeded : public std::runtime_error {
+    LimitKind limitKind;
+    std::size_t limitValue;
+
+    static std::string describe(LimitKind kind, std::size_t limit) {
+        const std::string value = std::to_string(limit);
+        switch (kind) {
+        case LimitKind::InputBytes: return "Limit error: input longer than " + value + " bytes";
+        case LimitKind::Tokens: return "Limit error: more than " + value + " tokens";
+        case LimitKind::Nesting: return "Limit error: nesting deeper than " + value;
+        default: return "Limit error: stack deeper than " + value;
+        }
+    }
+
+public:
+    LimitExceeded(LimitKind kind, std::size_t limit) : std::runtime_error(describe(kind, limit)), limitKind(kind), limitValue(limit) {}
+
+    LimitKind kind() const noexcept { return limitKind; }
+    std::size_t limit() const noexcept { return limitValue; }
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include "program.h"
+
+// Дерево выражения, построенное по байткоду. Узел хранит инструкцию и индексы дочерних узлов;
+// константы и переменные по-прежнему ссылаются на пулы исходной программы.
+struct ExpressionNode {
+    static constexpr std::uint32_t kNoChild = static_cast<std::uint32_t>(-1);
+
+    Instruction instruction;
+    std::uint32_t left{ kNoChild };
+    std::uint32_t right{ kNoChild };
+};
+
+struct ExpressionTree {
+    std::vector<ExpressionNode> nodes;
+    std::uint32_t root{ 0 };
+
+    static ExpressionTree build(const Program& program) {
+        ExpressionTree tree;
+        tree.nodes.reserve(program.code.size());
+        std::vector<std::uint32_t> operandStack;
+        operandStack.reserve(program.stackDepth);
+
+        for (const Instruction& instruction : program.code) {
+            ExpressionNode node;
+            node.instruction = instruction;
+            std::size_t arity = instructionArity(instruction);
+            if (operandStack.size() < arity) throw std::runtime_error("Compiler error: stack underflow");
+            if (arity == 2) {
+                node.right = operandStack.back();
+                operandStack.pop_back();
+            }
+            if (arity >= 1) {
+                node.left = operandStack.back();
+                operandStack.pop_back();
+            }
+            operandStack.push_back(tree.add(node));
+        }
+        if (operandStack.size() != 1) throw std::runtime_error("Compiler error: invalid expression");
+        tree.root = operandStack.back();
+        return tree;
+    }
+
+    std::uint32_t add(const ExpressionNode& node) {
+        nodes.push_back(node);
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+
+    std::size_t arity(std::uint32_t index) const {
+        return instructionArity(nodes[index].instruction);
+    }
+
+    // Число Сетхи-Ульмана: глубина стека, нужная для вычисления поддерева
+    std::vector<std::size_t> stackNeeds() const {
+        std::vector<std::size_t> needs(nodes.size(), 1);
+        for (std::uint32_t index : postOrder(root)) {
+            const ExpressionNode& node = nodes[index];
+            if (node.left == ExpressionNode::kNoChild) continue;
+            if (node.right == ExpressionNode::kNoChild) {
+                needs[index] = needs[node.left];
+                continue;
+            }
+            std::size_t leftNeed = needs[node.left], rightNeed = needs[node.right];
+            needs[index] = leftNeed == rightNeed ? leftNeed + 1 : (leftNeed > rightNeed ? leftNeed : rightNeed + 1);
+            if (isCommutative(node.instruction.opCode) && rightNeed > leftNeed) needs[index] = rightNeed;
+        }
+        return needs;
+    }
+
+    // Порядок обхода: дочерние узлы раньше родителя, левый раньше правого (без рекурсии)
+    std::vector<std::uint32_t> postOrder(std::uint32_t start) const {
+        std::vector<std::uint32_t> order;
+        std::vector<std::pair<std::uint32_t, bool>> pending{ { start, false } };
+        while (!pending.empty()) {
+            auto [index, expanded] = pending.back();
+            pending.pop_back();
+            if (expanded) {
+                order.push_back(index);
+                continue;
+            }
+            pending.push_back({ index, true });
+            const ExpressionNode& node = nodes[index];
+            if (node.right != ExpressionNode::kNoChild) pending.push_back({ node.right, false });
+            if (node.left != ExpressionNode::kNoChild) pending.push_back({ node.left, false });
+        }
+        return order;
+    }
+
+    // Перестановка операндов + и * не меняет результат в IEEE 754
+    static bool isCommutative(OpCode opCode) {
+        return opCode == OpCode::Add || opCode == OpCode::Multiply;
+    }
+
+    // Запись байткода. С minimizeStack у коммутативных операций первым вычисляется
+    // более "глубокий" операнд, что уменьшает глубину стека для сбалансированных деревьев
+    std::vector<Instruction> emit(bool minimizeStack = false) const {
+        std::vector<std::size_t> needs;
+        if (minimizeStack) needs = stackNeeds();
+
+        std::vector<Instruction> code;
+        code.reserve(nodes.size());
+        std::vector<std::pair<std::uint32_t, bool>> pending{ { root, false } };
+        while (!pending.empty()) {
+            auto [index, expanded] = pending.back();
+            pending.pop_back();
+            const ExpressionNode& node = nodes[index];
+            if (expanded) {
+                code.push_back(node.instruction);
+                continue;
+            }
+            pending.push_back({ index, true });
+            std::uint32_t first = node.left, second = node.right;
+            if (minimizeStack && second != ExpressionNode::kNoChild && isCommutative(node.instruction.opCode) &&
+                needs[second] > needs[first]) {
+                std::swap(first, second);
+            }
+            if (second != ExpressionNode::kNoChild) pending.push_back({ second, false });
+            if (first != ExpressionNode::kNoChild) pending.push_back({ first, false });
+        }
+        return code;
+    }
+};
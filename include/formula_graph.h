@@ -0,0 +1,195 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstddef>
+#include "translator.h"
+#include "program.h"
+#include "thread_pool.h"
+
+// Граф именованных формул ("margin = revenue - cost", "ratio = margin / revenue").
+// Каждая формула компилируется один раз; имена, не определенные как формулы, считаются входами.
+// Вычисление идет по уровням топологического порядка, формулы одного уровня независимы и считаются параллельно.
+class FormulaGraph {
+    struct Node {
+        std::string name;
+        bool isFormula{ false };
+        Program program;
+        std::vector<std::size_t> arguments;   // Узел для каждого слота program.variables
+        double value{ 0.0 };
+        bool hasValue{ false };
+        std::string error;
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<std::string, std::size_t> nodeIndex;
+    std::vector<std::vector<std::size_t>> levels;
+    bool structureChanged{ false };
+    Translator translator;
+
+    // Формулы одного уровня раздаются потокам кусками не меньше этого размера
+    static constexpr std::size_t kMinParallelChunk = 256;
+
+    std::size_t nodeFor(const std::string& name) {
+        auto found = nodeIndex.find(name);
+        if (found != nodeIndex.end()) return found->second;
+        nodes.push_back(Node{});
+        nodes.back().name = name;
+        nodeIndex.emplace(name, nodes.size() - 1);
+        return nodes.size() - 1;
+    }
+
+    static std::string trim(const std::string& text) {
+        std::size_t begin = 0, end = text.size();
+        while (begin < end && Lexer::isWhitespace(text[begin])) begin++;
+        while (end > begin && Lexer::isWhitespace(text[end - 1])) end--;
+        return text.substr(begin, end - begin);
+    }
+
+    static bool isValidName(const std::string& name) {
+        if (name.empty() || !Lexer::isIdentifierStart(name[0])) return false;
+        for (char ch : name) {
+            if (!Lexer::isIdentifierChar(ch)) return false;
+        }
+        return true;
+    }
+
+    // Алгоритм Кана по уровням; оставшиеся с ненулевой входящей степенью узлы образуют цикл
+    void rebuildLevels() {
+        std::vector<std::size_t> pendingInputs(nodes.size(), 0);
+        std::vector<std::vector<std::size_t>> dependents(nodes.size());
+        std::vector<std::size_t> frontier;
+        std::size_t formulaCount = 0;
+
+        for (std::size_t index = 0; index < nodes.size(); ++index) {
+            const Node& node = nodes[index];
+            if (!node.isFormula) continue;
+            formulaCount++;
+            for (std::size_t argument : node.arguments) {
+                if (nodes[argument].isFormula) {
+                    pendingInputs[index]++;
+                    dependents[argument].push_back(index);
+                }
+            }
+            if (pendingInputs[index] == 0) frontier.push_back(index);
+        }
+
+        levels.clear();
+        std::size_t scheduled = 0;
+        while (!frontier.empty()) {
+            std::vector<std::size_t> next;
+            for (std::size_t index : frontier) {
+                for (std::size_t dependent : dependents[index]) {
+                    if (--pendingInputs[dependent] == 0) next.push_back(dependent);
+                }
+            }
+            scheduled += frontier.size();
+            levels.push_back(std::move(frontier));
+            frontier = std::move(next);
+        }
+
+        if (scheduled != formulaCount) {
+            for (std::size_t index = 0; index < nodes.size(); ++index) {
+                if (nodes[index].isFormula && pendingInputs[index] != 0) {
+                    levels.clear();
+                    throw std::runtime_error("FormulaGraph error: cycle involving '" + nodes[index].name + "'");
+                }
+            }
+        }
+        structureChanged = false;
+    }
+
+    void evaluateNode(Node& node, Eval& evaluator, std::vector<double>& argumentValues) {
+        argumentValues.resize(node.arguments.size());
+        for (std::size_t slot = 0; slot < node.arguments.size(); ++slot) {
+            const Node& argument = nodes[node.arguments[slot]];
+            if (!argument.hasValue) {
+                node.hasValue = false;
+                node.error = "FormulaGraph error: '" + node.name + "' depends on '" + argument.name + "' which has no value";
+                return;
+            }
+            argumentValues[slot] = argument.value;
+        }
+        try {
+            node.value = evaluator.evaluateProgram(node.program, argumentValues.data());
+            node.hasValue = true;
+            node.error.clear();
+        }
+        catch (const std::exception& e) {
+            node.hasValue = false;
+            node.error = "FormulaGraph error: '" + node.name + "': " + e.what();
+        }
+    }
+
+public:
+    // Определение или переопределение формулы
+    void define(const std::string& name, const std::string& expression) {
+        if (!isValidName(name)) throw std::runtime_error("FormulaGraph error: invalid name '" + name + "'");
+        Program program = translator.compile(expression);
+
+        std::size_t index = nodeFor(name);
+        std::vector<std::size_t> arguments;
+        arguments.reserve(program.variables.size());
+        for (const std::string& variable : program.variables) {
+            arguments.push_back(nodeFor(variable));
+        }
+
+        Node& node = nodes[index];
+        node.isFormula = true;
+        node.program = std::move(program);
+        node.arguments = std::move(arguments);
+        node.hasValue = false;
+        structureChanged = true;
+    }
+
+    // Определение в форме "name = expression"
+    void define(const std::string& definition) {
+        std::size_t separator = definition.find('=');
+        if (separator == std::string::npos) throw std::runtime_error("FormulaGraph error: '=' expected");
+        define(trim(definition.substr(0, separator)), definition.substr(separator + 1));
+    }
+
+    void setInput(const std::string& name, double value) {
+        if (!isValidName(name)) throw std::runtime_error("FormulaGraph error: invalid name '" + name + "'");
+        Node& node = nodes[nodeFor(name)];
+        if (node.isFormula) throw std::runtime_error("FormulaGraph error: '" + name + "' is a formula");
+        node.value = value;
+        node.hasValue = true;
+    }
+
+    // Последовательное вычисление всех формул
+    void evaluate() {
+        if (structureChanged) rebuildLevels();
+        Eval evaluator;
+        std::vector<double> argumentValues;
+        for (const std::vector<std::size_t>& level : levels) {
+            for (std::size_t index : level) evaluateNode(nodes[index], evaluator, argumentValues);
+        }
+    }
+
+    // Параллельное вычисление: уровни по очереди, формулы внутри уровня в пуле
+    void evaluate(ThreadPool& pool) {
+        if (structureChanged) rebuildLevels();
+        for (const std::vector<std::size_t>& level : levels) {
+            pool.parallelFor(level.size(), [&](std::size_t begin, std::size_t end) {
+                Eval evaluator;
+                std::vector<double> argumentValues;
+                for (std::size_t i = begin; i < end; ++i) evaluateNode(nodes[level[i]], evaluator, argumentValues);
+            }, kMinParallelChunk);
+        }
+    }
+
+    double value(const std::string& name) const {
+        auto found = nodeIndex.find(name);
+        if (found == nodeIndex.end()) throw std::runtime_error("FormulaGraph error: unknown name '" + name + "'");
+        const Node& node = nodes[found->second];
+        if (!node.hasValue) {
+            throw std::runtime_error(node.error.empty() ? "FormulaGraph error: '" + name + "' has no value" : node.error);
+        }
+        return node.value;
+    }
+
+    std::size_t size() const noexcept { return nodes.size(); }
+    std::size_t levelCount() const noexcept { return levels.size(); }
+};
@@ -0,0 +1,175 @@
+#pragma once
+#include <array>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <stdexcept>
+
+// Встроенные математические функции
+enum class MathFunction : std::uint8_t {
+    Sqrt,
+    Exp,
+    Log,
+    Pow,
+    Sin,
+    Cos,
+    Min,
+    Max,
+    Abs
+};
+
+struct MathFunctionInfo {
+    std::string_view name;
+    MathFunction id;
+    std::size_t arity;
+};
+
+inline constexpr std::array<MathFunctionInfo, 9> kMathFunctions = { {
+    { "sqrt", MathFunction::Sqrt, 1 },
+    { "exp",  MathFunction::Exp,  1 },
+    { "log",  MathFunction::Log,  1 },
+    { "pow",  MathFunction::Pow,  2 },
+    { "sin",  MathFunction::Sin,  1 },
+    { "cos",  MathFunction::Cos,  1 },
+    { "min",  MathFunction::Min,  2 },
+    { "max",  MathFunction::Max,  2 },
+    { "abs",  MathFunction::Abs,  1 },
+} };
+
+constexpr const MathFunctionInfo* findMathFunction(std::string_view name) {
+    for (const MathFunctionInfo& info : kMathFunctions) {
+        if (info.name == name) return &info;
+    }
+    return nullptr;
+}
+
+constexpr const MathFunctionInfo& mathFunctionInfo(MathFunction id) {
+    return kMathFunctions[static_cast<std::size_t>(id)];
+}
+
+// min/max через сравнение, чтобы скалярный и пакетный пути давали одинаковый результат
+inline double mathMin(double left, double right) { return right < left ? right : left; }
+inline double mathMax(double left, double right) { return left < right ? right : left; }
+
+// Ошибка области определения: NaN из аргументов, которые сами не NaN (sqrt(-1), log(-1), pow(-8, 1/3))
+inline void throwMathDomainError(MathFunction id) {
+    throw std::runtime_error("Eval error: " + std::string(mathFunctionInfo(id).name) + " domain error");
+}
+
+inline double applyMathFunction(MathFunction id, double first, double second = 0.0) {
+    double result = 0.0;
+    switch (id) {
+    case MathFunction::Sqrt: result = std::sqrt(first); break;
+    case MathFunction::Exp: result = std::exp(first); break;
+    case MathFunction::Log:
+        if (first == 0.0) throwMathDomainError(id);
+        result = std::log(first);
+        break;
+    case MathFunction::Pow: result = std::pow(first, second); break;
+    case MathFunction::Sin: result = std::sin(first); break;
+    case MathFunction::Cos: result = std::cos(first); break;
+    case MathFunction::Min: return mathMin(first, second);
+    case MathFunction::Max: return mathMax(first, second);
+    case MathFunction::Abs: return std::fabs(first);
+    default: throw std::runtime_error("Eval error: unknown function");
+    }
+    if (std::isnan(result) && !std::isnan(first) && !std::isnan(second)) throwMathDomainError(id);
+    return result;
+}
+
+// Возведение в степень: целый показатель-константа считается умножениями
+inline constexpr int kMaxIntegerExponent = 64;
+
+constexpr bool isSmallIntegerExponent(double exponent) {
+    return exponent >= -kMaxIntegerExponent && exponent <= kMaxIntegerExponent &&
+           static_cast<double>(static_cast<int>(exponent)) == exponent;
+}
+
+// Бинарное возведение в степень; отрицательный показатель - обратная величина (0^-n дает inf, как pow)
+constexpr double integerPower(double base, int exponent) {
+    unsigned magnitude = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+    double result = 1.0;
+    while (magnitude != 0) {
+        if (magnitude & 1u) result *= base;
+        magnitude >>= 1;
+        if (magnitude != 0) base *= base;
+    }
+    return exponent < 0 ? 1.0 / result : result;
+}
+
+// Пакетная версия integerPower с тем же порядком умножений, что и скалярная
+inline void integerPower(const double* bases, int exponent, double* results, double* scratch, std::size_t count) {
+    unsigned magnitude = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+    // results может совпадать с bases, поэтому сначала копируем основание
+    for (std::size_t i = 0; i < count; ++i) scratch[i] = bases[i];
+    for (std::size_t i = 0; i < count; ++i) results[i] = 1.0;
+    while (magnitude != 0) {
+        if (magnitude & 1u) {
+            for (std::size_t i = 0; i < count; ++i) results[i] *= scratch[i];
+        }
+        magnitude >>= 1;
+        if (magnitude != 0) {
+            for (std::size_t i = 0; i < count; ++i) scratch[i] *= scratch[i];
+        }
+    }
+    if (exponent < 0) {
+        for (std::size_t i = 0; i < count; ++i) results[i] = 1.0 / results[i];
+    }
+}
+
+// Пакетная версия для столбцов: один проход по массиву на функцию.
+// sqrt/abs/min/max компилятор векторизует; exp/log/pow/sin/cos вызывают libm поэлементно,
+// чтобы результат совпадал со скалярным путем бит в бит.
+inline void applyMathFunction(MathFunction id, const double* first, const double* second, double* results, std::size_t count) {
+    switch (id) {
+    case MathFunction::Sqrt:
+        for (std::size_t i = 0; i < count; ++i) results[i] = std::sqrt(first[i]);
+        break;
+    case MathFunction::Exp:
+        for (std::size_t i = 0; i < count; ++i) results[i] = std::exp(first[i]);
+        break;
+    case MathFunction::Log: {
+        bool zeroArgument = false;
+        for (std::size_t i = 0; i < count; ++i) zeroArgument |= first[i] == 0.0;
+        if (zeroArgument) throwMathDomainError(id);
+        for (std::size_t i = 0; i < count; ++i) results[i] = std::log(first[i]);
+        break;
+    }
+    case MathFunction::Pow:
+        for (std::size_t i = 0; i < count; ++i) results[i] = std::pow(first[i], second[i]);
+        break;
+    case MathFunction::Sin:
+        for (std::size_t i = 0; i < count; ++i) results[i] = std::sin(first[i]);
+        break;
+    case MathFunction::Cos:
+        for (std::size_t i = 0; i < count; ++i) results[i] = std::cos(first[i]);
+        break;
+    case MathFunction::Min:
+        for (std::size_t i = 0; i < count; ++i) results[i] = mathMin(first[i], second[i]);
+        return;
+    case MathFunction::Max:
+        for (std::size_t i = 0; i < count; ++i) results[i] = mathMax(first[i], second[i]);
+        return;
+    case MathFunction::Abs:
+        for (std::size_t i = 0; i < count; ++i) results[i] = std::fabs(first[i]);
+        return;
+    default:
+        throw std::runtime_error("Eval error: unknown function");
+    }
+
+    // Проверка области определения одним проходом без ветвлений в цикле
+    bool domainError = false;
+    if (mathFunctionInfo(id).arity == 2) {
+        for (std::size_t i = 0; i < count; ++i) {
+            domainError |= results[i] != results[i] && first[i] == first[i] && second[i] == second[i];
+        }
+    }
+    else {
+        for (std::size_t i = 0; i < count; ++i) {
+            domainError |= results[i] != results[i] && first[i] == first[i];
+        }
+    }
+    if (domainError) throwMathDomainError(id);
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include "program.h"
+
+// Инкрементальное вычисление скомпилированного выражения.
+// Значения всех подвыражений кэшируются; при изменении переменной пересчитываются
+// только узлы на пути от ее листьев к корню, то есть O(затронутый путь) вместо O(размер выражения).
+class IncrementalEval {
+    static constexpr std::uint32_t kNoNode = static_cast<std::uint32_t>(-1);
+
+    struct Node {
+        OpCode opCode{ OpCode::PushConstant };
+        MathFunction function{ MathFunction::Sqrt };
+        int exponent{ 0 };   // Для PowerInt
+        double divisor{ 1.0 };   // Для DivideConstant
+        std::uint32_t left{ kNoNode };
+        std::uint32_t right{ kNoNode };
+        std::uint32_t parent{ kNoNode };
+        double value{ 0.0 };
+        bool dirty{ false };
+    };
+
+    // Узлы в порядке байткода: дочерние всегда раньше родителя
+    std::vector<Node> nodes;
+    std::vector<std::vector<std::uint32_t>> variableLeaves;
+    std::vector<double> variableValues;
+    std::vector<std::string> variableNames;
+    std::vector<std::uint32_t> dirtyNodes;
+    std::size_t recomputedCount{ 0 };
+
+    // Помечаем путь до корня; подъем останавливается на уже помеченном узле
+    void markDirty(std::uint32_t index) {
+        while (index != kNoNode && !nodes[index].dirty) {
+            nodes[index].dirty = true;
+            dirtyNodes.push_back(index);
+            index = nodes[index].parent;
+        }
+    }
+
+    void recompute(Node& node) {
+        switch (node.opCode) {
+        case OpCode::PushConstant:
+            break;
+        case OpCode::PushVariable:
+            break;
+        case OpCode::Negate:
+            node.value = -nodes[node.left].value;
+            break;
+        case OpCode::Add:
+            node.value = nodes[node.left].value + nodes[node.right].value;
+            break;
+        case OpCode::Subtract:
+            node.value = nodes[node.left].value - nodes[node.right].value;
+            break;
+        case OpCode::Multiply:
+            node.value = nodes[node.left].value * nodes[node.right].value;
+            break;
+        case OpCode::Divide:
+            if (nodes[node.right].value == 0.0) throw std::runtime_error("Eval error: division by zero");
+            node.value = nodes[node.left].value / nodes[node.right].value;
+            break;
+        case OpCode::Power:
+            node.value = applyMathFunction(MathFunction::Pow, nodes[node.left].value, nodes[node.right].value);
+            break;
+        case OpCode::PowerInt:
+            node.value = integerPower(nodes[node.left].value, node.exponent);
+            break;
+        case OpCode::DivideConstant:
+            node.value = nodes[node.left].value / node.divisor;
+            break;
+        case OpCode::Call:
+            node.value = applyMathFunction(node.function, nodes[node.left].value,
+                                           node.right == kNoNode ? 0.0 : nodes[node.right].value);
+            break;
+        default:
+            throw std::runtime_error("Eval error: unknown instruction");
+        }
+    }
+
+public:
+    explicit IncrementalEval(const Program& program)
+        : variableLeaves(program.variables.size()),
+          variableValues(program.variables.size(), 0.0),
+          variableNames(program.variables) {
+        nodes.resize(program.code.size());
+        std::vector<std::uint32_t> operandStack;
+        operandStack.reserve(program.stackDepth);
+
+        for (std::uint32_t index = 0; index < program.code.size(); ++index) {
+            const Instruction& instruction = program.code[index];
+            Node& node = nodes[index];
+            node.opCode = instruction.opCode;
+
+            switch (instruction.opCode) {
+            case OpCode::PushConstant:
+                node.value = program.constants[instruction.operand];
+                break;
+            case OpCode::PushVariable:
+                variableLeaves[instruction.operand].push_back(index);
+                break;
+            case OpCode::Negate:
+                node.left = operandStack.back();
+                operandStack.pop_back();
+                break;
+            case OpCode::PowerInt:
+                node.exponent = powerIntExponent(instruction);
+                node.left = operandStack.back();
+                operandStack.pop_back();
+                break;
+            case OpCode::DivideConstant:
+                node.divisor = program.constants[instruction.operand];
+                node.left = operandStack.back();
+                operandStack.pop_back();
+                break;
+            case OpCode::Call:
+                node.function = static_cast<MathFunction>(instruction.operand);
+                if (mathFunctionInfo(node.function).arity == 2) {
+                    node.right = operandStack.back();
+                    operandStack.pop_back();
+                    nodes[node.right].parent = index;
+                }
+                node.left = operandStack.back();
+                operandStack.pop_back();
+                break;
+            default:
+                node.right = operandStack.back();
+                operandStack.pop_back();
+                node.left = operandStack.back();
+                operandStack.pop_back();
+                nodes[node.right].parent = index;
+                break;
+            }
+            if (node.left != kNoNode) nodes[node.left].parent = index;
+            operandStack.push_back(index);
+        }
+        if (operandStack.size() != 1) throw std::runtime_error("Eval error: invalid expression");
+
+        // Первое вычисление - полное
+        for (std::uint32_t index = 0; index < nodes.size(); ++index) {
+            nodes[index].dirty = true;
+            dirtyNodes.push_back(index);
+        }
+    }
+
+    std::size_t variableCount() const noexcept { return variableValues.size(); }
+
+    void setVariable(std::size_t slot, double value) {
+        if (slot >= variableValues.size()) throw std::out_of_range("IncrementalEval: unknown variable slot");
+        // Повторная установка того же значения ничего не пересчитывает (-0.0 и 0.0 различаются)
+        if (variableValues[slot] == value && std::signbit(variableValues[slot]) == std::signbit(value)) return;
+        variableValues[slot] = value;
+        for (std::uint32_t leaf : variableLeaves[slot]) {
+            nodes[leaf].value = value;
+            markDirty(leaf);
+        }
+    }
+
+    void setVariable(std::string_view name, double value) {
+        for (std::size_t slot = 0; slot < variableNames.size(); ++slot) {
+            if (variableNames[slot] == name) {
+                setVariable(slot, value);
+                return;
+            }
+        }
+        throw std::out_of_range("IncrementalEval: unknown variable");
+    }
+
+    // Пересчитывает помеченные узлы в порядке байткода и возвращает значение корня
+    double value() {
+        std::sort(dirtyNodes.begin(), dirtyNodes.end());
+        std::size_t processed = 0;
+        try {
+            for (; processed < dirtyNodes.size(); ++processed) {
+                Node& node = nodes[dirtyNodes[processed]];
+                recompute(node);
+                node.dirty = false;
+            }
+        }
+        catch (...) {
+            // Узел с ошибкой и его предки остаются помеченными до следующего вызова
+            dirtyNodes.erase(dirtyNodes.begin(), dirtyNodes.begin() + static_cast<std::ptrdiff_t>(processed));
+            recomputedCount = processed;
+            throw;
+        }
+        recomputedCount = processed;
+        dirtyNodes.clear();
+        return nodes.back().value;
+    }
+
+    // Сколько узлов пересчитал последний вызов value()
+    std::size_t lastRecomputedCount() const noexcept { return recomputedCount; }
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <array>
+#include <string_view>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "token.h"
+#include "static_translator.h"
+#include "functions.h"
+
+// Ядра выражений: строка, известная на этапе компиляции, превращается в дерево шаблонных типов,
+// которое компилятор разворачивает в линейную арифметику без стека и без диспетчеризации по операторам.
+// Переменные нумеруются в порядке первого появления в выражении: Kernel<"a*x+b">{}(a, x, b).
+
+#if defined(_MSC_VER)
+#define KERNEL_FORCE_INLINE __forceinline
+#else
+#define KERNEL_FORCE_INLINE [[gnu::always_inline]] inline
+#endif
+
+// Строковый литерал как параметр шаблона
+template <std::size_t Length>
+struct FixedString {
+    char text[Length]{};
+
+    constexpr FixedString(const char (&source)[Length]) {
+        for (std::size_t i = 0; i < Length; ++i) text[i] = source[i];
+    }
+
+    static constexpr std::size_t capacity() { return Length; }
+    constexpr std::string_view view() const { return std::string_view(text, Length - 1); }
+};
+
+// Узел дерева выражения; дочерние узлы - индексы в массиве RPN
+struct KernelNode {
+    TokenType type{ TokenType::End };
+    char operatorChar{ '\0' };
+    double numericValue{ 0.0 };
+    std::size_t slot{ 0 };
+    std::size_t left{ 0 };
+    std::size_t right{ 0 };
+};
+
+template <std::size_t Capacity>
+struct KernelTree {
+    std::array<KernelNode, Capacity> nodes{};
+    std::size_t root{ 0 };
+    std::array<std::size_t, Capacity> nameOffsets{};
+    std::array<std::size_t, Capacity> nameLengths{};
+    std::size_t variableCount{ 0 };
+};
+
+// Строит дерево по RPN из StaticParcer (те же приоритеты и ассоциативность, что у Parcer)
+template <std::size_t Capacity>
+consteval KernelTree<Capacity> buildKernelTree(std::string_view source) {
+    const StaticProgram<Capacity> program = StaticTranslator::compile<Capacity>(source);
+    KernelTree<Capacity> tree;
+    std::array<std::size_t, Capacity> operandStack{};
+    std::size_t stackSize = 0;
+
+    for (std::size_t i = 0; i < program.length; ++i) {
+        const StaticToken& token = program.tokens[i];
+        KernelNode node{ token.type, token.operatorChar, token.numericValue };
+
+        if (token.type == TokenType::Identifier) {
+            std::string_view name = source.substr(token.nameOffset, token.nameLength);
+            std::size_t slot = 0;
+            while (slot < tree.variableCount && source.substr(tree.nameOffsets[slot], tree.nameLengths[slot]) != name) {
+                slot++;
+            }
+            if (slot == tree.variableCount) {
+                tree.nameOffsets[slot] = token.nameOffset;
+                tree.nameLengths[slot] = token.nameLength;
+                tree.variableCount++;
+            }
+            node.slot = slot;
+        }
+        else if (token.type == TokenType::Operator) {
+            if (token.operatorChar == '~') {
+                if (stackSize < 1) throw std::runtime_error("Eval error: unary minus needs 1 operand");
+                node.left = operandStack[--stackSize];
+            }
+            else {
+                if (stackSize < 2) throw std::runtime_error("Eval error: binary operator needs 2 operands");
+                node.right = operandStack[--stackSize];
+                node.left = operandStack[--stackSize];
+            }
+        }
+        tree.nodes[i] = node;
+        operandStack[stackSize++] = i;
+    }
+
+    if (stackSize != 1) throw std::runtime_error("Eval error: invalid expression");
+    tree.root = operandStack[0];
+    return tree;
+}
+
+template <double Value>
+struct KernelConstant {
+    static constexpr bool isNonZeroConstant = Value != 0.0;
+    static constexpr bool isSmallIntegerConstant = isSmallIntegerExponent(Value);
+    static constexpr int integerValue = isSmallIntegerConstant ? static_cast<int>(Value) : 0;
+    KERNEL_FORCE_INLINE static constexpr double apply(const double*) { return Value; }
+};
+
+template <std::size_t Slot>
+struct KernelVariable {
+    static constexpr bool isNonZeroConstant = false;
+    static constexpr bool isSmallIntegerConstant = false;
+    KERNEL_FORCE_INLINE static constexpr double apply(const double* values) { return values[Slot]; }
+};
+
+template <typename Operand>
+struct KernelNegate {
+    static constexpr bool isNonZeroConstant = false;
+    static constexpr bool isSmallIntegerConstant = false;
+    KERNEL_FORCE_INLINE static constexpr double apply(const double* values) { return -Operand::apply(values); }
+};
+
+template <char Operator, typename Left, typename Right>
+struct KernelBinary {
+    static constexpr bool isNonZeroConstant = false;
+    static constexpr bool isSmallIntegerConstant = false;
+    KERNEL_FORCE_INLINE static constexpr double apply(const double* values) {
+        const double leftOperand = Left::apply(values);
+        const double rightOperand = Right::apply(values);
+        if constexpr (Operator == '+') return leftOperand + rightOperand;
+        else if constexpr (Operator == '-') return leftOperand - rightOperand;
+        else if constexpr (Operator == '*') return leftOperand * rightOperand;
+        else if constexpr (Operator == '^') {
+            // Целый показатель-константа разворачивается в умножения; остальное - pow, как в Eval
+            // (pow не constexpr, поэтому на этапе компиляции умножениями считается любой целый показатель)
+            if constexpr (Right::isSmallIntegerConstant) return integerPower(leftOperand, Right::integerValue);
+            else {
+                if (std::is_constant_evaluated() && isSmallIntegerExponent(rightOperand)) {
+                    return integerPower(leftOperand, static_cast<int>(rightOperand));
+                }
+                return applyMathFunction(MathFunction::Pow, leftOperand, rightOperand);
+            }
+        }
+        else {
+            static_assert(Operator == '/', "Kernel: unknown operator");
+            // Проверка на ноль не нужна, если делитель - ненулевая константа
+            if constexpr (!Right::isNonZeroConstant) {
+                if (rightOperand == 0.0) throw std::runtime_error("Eval error: division by zero");
+            }
+            return leftOperand / rightOperand;
+        }
+    }
+};
+
+template <FixedString Source>
+struct KernelSource {
+    static constexpr KernelTree<Source.capacity()> tree = buildKernelTree<Source.capacity()>(Source.view());
+};
+
+template <FixedString Source, std::size_t Index>
+constexpr auto makeKernelNode() {
+    constexpr KernelNode node = KernelSource<Source>::tree.nodes[Index];
+    if constexpr (node.type == TokenType::Number) {
+        return KernelConstant<node.numericValue>{};
+    }
+    else if constexpr (node.type == TokenType::Identifier) {
+        return KernelVariable<node.slot>{};
+    }
+    else if constexpr (node.operatorChar == '~') {
+        return KernelNegate<decltype(makeKernelNode<Source, node.left>())>{};
+    }
+    else {
+        return KernelBinary<node.operatorChar,
+                            decltype(makeKernelNode<Source, node.left>()),
+                            decltype(makeKernelNode<Source, node.right>())>{};
+    }
+}
+
+template <FixedString Source>
+class Kernel {
+    static constexpr const auto& tree = KernelSource<Source>::tree;
+
+public:
+    using Expression = decltype(makeKernelNode<Source, tree.root>());
+    static constexpr std::size_t arity = tree.variableCount;
+
+    static constexpr std::string_view variableName(std::size_t slot) {
+        return Source.view().substr(tree.nameOffsets[slot], tree.nameLengths[slot]);
+    }
+
+    template <typename... Args>
+        requires (sizeof...(Args) == arity)
+    constexpr double operator()(Args... args) const {
+        const std::array<double, arity> values{ static_cast<double>(args)... };
+        return Expression::apply(values.data());
+    }
+
+    // Значения переменных по номерам слотов
+    constexpr double operator()(const double* values) const {
+        return Expression::apply(values);
+    }
+};
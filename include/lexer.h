@@ -1,100 +1,355 @@
 #pragma once
 #include <string>
 #include <stdexcept>
-#include <cctype>
 #include <cstdlib>
+#include <cstdint>
+#include <array>
+#include <charconv>
+#include <system_error>
+#include <limits>
 #include "token.h"
+#include "evaluation_limits.h"
 
-// Лексический анализатор: разбивает строку на токены
+// Лексический анализатор: разбивает строку на токены.
+// Класс байта берется из таблицы на 256 элементов, числа и имена распознает автомат
+// с таблицей переходов: на каждый байт один поиск и одна проверка выхода.
+// Границы чисел совпадают с std::strtod (включая 1e5, 1., .5 и шестнадцатеричные 0x1p3)
 class Lexer {
+public:
+    enum CharClass : std::uint8_t {
+        Other, Space, LeftParen, RightParen, Comma,
+        Plus, Minus, Operator,   // Остальные операторы: * / ^
+        Zero, Digit, Dot,
+        LetterE, LetterX, LetterP, HexLetter, Letter,
+        ClassCount
+    };
+
+private:
+    // Состояния автомата; из Start начинается каждое число и имя, Dead - конец лексемы
+    enum State : std::uint8_t {
+        Dead, Start, Name,
+        LeadZero, Integer, LeadDot, Fraction, ExponentMark, ExponentSign, Exponent,
+        HexPrefix, HexInteger, HexLeadDot, HexFraction, HexExponentMark, HexExponentSign, HexExponent,
+        StateCount
+    };
+
+    static constexpr std::uint32_t kAccepting = (1u << Name) | (1u << LeadZero) | (1u << Integer) | (1u << Fraction) |
+                                                (1u << Exponent) | (1u << HexInteger) | (1u << HexFraction) | (1u << HexExponent);
+
+    static constexpr std::array<std::uint8_t, 256> kCharClasses = [] {
+        std::array<std::uint8_t, 256> table{};
+        for (unsigned char ch : { ' ', '\t', '\n', '\r' }) table[ch] = Space;
+        table['('] = LeftParen;
+        table[')'] = RightParen;
+        table[','] = Comma;
+        table['+'] = Plus;
+        table['-'] = Minus;
+        for (unsigned char ch : { '*', '/', '^' }) table[ch] = Operator;
+        table['0'] = Zero;
+        for (unsigned char ch = '1'; ch <= '9'; ++ch) table[ch] = Digit;
+        table['.'] = Dot;
+        for (unsigned char ch = 'a'; ch <= 'z'; ++ch) {
+            table[ch] = Letter;
+            table[ch - 'a' + 'A'] = Letter;
+        }
+        table['_'] = Letter;
+        for (unsigned char ch : { 'a', 'b', 'c', 'd', 'f', 'A', 'B', 'C', 'D', 'F' }) table[ch] = HexLetter;
+        table['e'] = table['E'] = LetterE;
+        table['x'] = table['X'] = LetterX;
+        table['p'] = table['P'] = LetterP;
+        return table;
+    }();
+
+    static constexpr std::array<std::array<std::uint8_t, ClassCount>, StateCount> kTransitions = [] {
+        std::array<std::array<std::uint8_t, ClassCount>, StateCount> table{};
+        auto on = [&table](State from, std::initializer_list<CharClass> classes, State to) {
+            for (CharClass charClass : classes) table[from][charClass] = to;
+        };
+        const std::initializer_list<CharClass> letters = { LetterE, LetterX, LetterP, HexLetter, Letter };
+        const std::initializer_list<CharClass> digits = { Zero, Digit };
+        const std::initializer_list<CharClass> hexDigits = { Zero, Digit, LetterE, HexLetter };
+
+        on(Start, { Zero }, LeadZero);
+        on(Start, { Digit }, Integer);
+        on(Start, { Dot }, LeadDot);
+        on(Start, letters, Name);
+        on(Name, letters, Name);
+        on(Name, digits, Name);
+
+        on(LeadZero, digits, Integer);
+        on(LeadZero, { Dot }, Fraction);
+        on(LeadZero, { LetterE }, ExponentMark);
+        on(LeadZero, { LetterX }, HexPrefix);
+        on(Integer, digits, Integer);
+        on(Integer, { Dot }, Fraction);
+        on(Integer, { LetterE }, ExponentMark);
+        on(LeadDot, digits, Fraction);
+        on(Fraction, digits, Fraction);
+        on(Fraction, { LetterE }, ExponentMark);
+        on(ExponentMark, { Plus, Minus }, ExponentSign);
+        on(ExponentMark, digits, Exponent);
+        on(ExponentSign, digits, Exponent);
+        on(Exponent, digits, Exponent);
+
+        on(HexPrefix, hexDigits, HexInteger);
+        on(HexPrefix, { Dot }, HexLeadDot);
+        on(HexInteger, hexDigits, HexInteger);
+        on(HexInteger, { Dot }, HexFraction);
+        on(HexInteger, { LetterP }, HexExponentMark);
+        on(HexLeadDot, hexDigits, HexFraction);
+        on(HexFraction, hexDigits, HexFraction);
+        on(HexFraction, { LetterP }, HexExponentMark);
+        on(HexExponentMark, { Plus, Minus }, HexExponentSign);
+        on(HexExponentMark, digits, HexExponent);
+        on(HexExponentSign, digits, HexExponent);
+        on(HexExponent, digits, HexExponent);
+        return table;
+    }();
+
+    static constexpr std::uint8_t classOf(char ch) { return kCharClasses[static_cast<unsigned char>(ch)]; }
+
     std::string inputText;
     size_t currentPosition{ 0 };
-    Token lastToken{ Token::createEnd() };  // Для определения унарного минуса
-    
-    static bool isWhitespace(char ch) {
-        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+    TokenType lastType{ TokenType::End };  // Для определения унарного минуса
+
+    // Токен без строки содержимого: границы в тексте, символ оператора, значение числа
+    struct Lexeme {
+        TokenType type{ TokenType::End };
+        char op{ '\0' };
+        double value{ 0.0 };
+        size_t begin{ 0 };
+        size_t end{ 0 };
+    };
+
+    // Самая длинная допустимая лексема с позиции begin; begin, если ее нет.
+    // Строка завершается '\0' (класс Other), поэтому отдельной проверки конца ввода не нужно
+    static size_t scan(const char* text, size_t begin) {
+        size_t position = begin;
+        size_t acceptedEnd = begin;
+        std::uint8_t state = Start;
+        for (;;) {
+            state = kTransitions[state][classOf(text[position])];
+            if (state == Dead) break;
+            position++;
+            acceptedEnd = (kAccepting >> state) & 1u ? position : acceptedEnd;
+        }
+        return acceptedEnd;
     }
 
-    static bool isValidOperator(char ch) {
-        return ch == '+' || ch == '-' || ch == '*' || ch == '/';
+    static double parseNumber(const char* first, const char* last) {
+        // Шестнадцатеричные, переполнение и денормалы отдаем strtod, он и задает эталонное значение
+        if (last - first <= 2 || (first[1] != 'x' && first[1] != 'X')) {
+            double value = 0.0;
+            auto [end, error] = std::from_chars(first, last, value);
+            if (error == std::errc() && end == last) return value;
+        }
+        return std::strtod(first, nullptr);
     }
 
-    void advancePastWhitespace() {
-        while (currentPosition < inputText.size() && isWhitespace(inputText[currentPosition])) {
-            currentPosition++;
+    // Следующий значимый символ - открывающая скобка (имя функции, а не переменной)
+    static bool nextIsLeftParen(const char* text, size_t lookahead) {
+        while (classOf(text[lookahead]) == Space) lookahead++;
+        return text[lookahead] == '(';
+    }
+
+    // Состояние чтения. Текст завершается '\0'; limit - конец разбираемого участка,
+    // символ на нем должен быть границей токена (см. tokenizeRange)
+    struct Cursor {
+        const char* text;
+        size_t limit;
+        size_t position;
+        TokenType lastType;
+    };
+
+    static Lexeme nextLexeme(Cursor& cursor) {
+        const char* text = cursor.text;
+        size_t& position = cursor.position;
+        // Пропускаем пробелы; '\0' в конце строки их не продолжает
+        while (classOf(text[position]) == Space) position++;
+        Lexeme lexeme;
+        lexeme.begin = position;
+        if (position >= cursor.limit) {
+            lexeme.end = position;
+            cursor.lastType = TokenType::End;
+            return lexeme;
+        }
+
+        const char currentChar = text[position];
+        switch (classOf(currentChar)) {
+        case LeftParen:
+            lexeme.type = TokenType::LeftParen;
+            position++;
+            break;
+        case RightParen:
+            lexeme.type = TokenType::RightParen;
+            position++;
+            break;
+        case Comma:
+            lexeme.type = TokenType::Comma;
+            position++;
+            break;
+        case Minus:
+            // Определяем унарный или бинарный минус
+            lexeme.type = TokenType::Operator;
+            lexeme.op = canBeUnaryMinus(cursor.lastType) ? '~' : '-';
+            position++;
+            break;
+        case Plus:
+        case Operator:
+            lexeme.type = TokenType::Operator;
+            lexeme.op = currentChar;
+            position++;
+            break;
+        case Zero:
+        case Digit:
+        case Dot: {
+            size_t numberEnd = scan(text, position);
+            if (numberEnd == position) {
+                throw std::runtime_error("Lexer error: invalid number");
+            }
+            lexeme.type = TokenType::Number;
+            lexeme.value = parseNumber(text + position, text + numberEnd);
+            position = numberEnd;
+            break;
+        }
+        case LetterE:
+        case LetterX:
+        case LetterP:
+        case HexLetter:
+        case Letter:
+            // Имена переменных и функций
+            position = scan(text, position);
+            lexeme.type = nextIsLeftParen(text, position) ? TokenType::Function : TokenType::Identifier;
+            break;
+        default:
+            throw std::runtime_error(std::string("Lexer error: unexpected character '") + currentChar + "'");
         }
+        lexeme.end = position;
+        cursor.lastType = lexeme.type;
+        return lexeme;
     }
 
-    // Унарный минус возможен после начала выражения, оператора или открывающей скобки
-    bool canBeUnaryMinus() const {
-        if (lastToken.type == TokenType::End) return true;
-        if (lastToken.type == TokenType::Operator) return true;
-        if (lastToken.type == TokenType::LeftParen) return true;
-        return false;
+    Lexeme nextLexeme() {
+        Cursor cursor{ inputText.c_str(), inputText.size(), currentPosition, lastType };
+        Lexeme lexeme = nextLexeme(cursor);
+        currentPosition = cursor.position;
+        lastType = cursor.lastType;
+        return lexeme;
+    }
+
+    // Токены до конца участка, включая End. Ошибка записывается в tokens.error (см. TokenBuffer),
+    // превышение maxTokens бросается как LimitExceeded
+    static void tokenizeSpan(Cursor& cursor, TokenBuffer& tokens, std::size_t maxTokens = EvaluationLimits::kUnlimited) {
+        try {
+            for (;;) {
+                Lexeme lexeme = nextLexeme(cursor);
+                if (tokens.size() >= maxTokens && lexeme.type != TokenType::End) throw LimitExceeded(LimitKind::Tokens, maxTokens);
+                tokens.push(lexeme.type, lexeme.op, lexeme.value, lexeme.begin, lexeme.end - lexeme.begin);
+                if (lexeme.type == TokenType::End) return;
+            }
+        }
+        catch (const LimitExceeded&) {
+            throw;
+        }
+        catch (const std::runtime_error& e) {
+            tokens.error = e.what();
+            tokens.push(TokenType::End, '\0', 0.0, cursor.position, 0);
+        }
     }
 
 public:
+    // Унарный минус возможен после начала выражения, оператора, открывающей скобки или запятой
+    static bool canBeUnaryMinus(TokenType lastType) {
+        if (lastType == TokenType::End) return true;
+        if (lastType == TokenType::Operator) return true;
+        if (lastType == TokenType::LeftParen) return true;
+        if (lastType == TokenType::Comma) return true;
+        return false;
+    }
+
+    static constexpr bool isWhitespace(char ch) {
+        return classOf(ch) == Space;
+    }
+
+    static constexpr bool isValidOperator(char ch) {
+        return classOf(ch) == Plus || classOf(ch) == Minus || classOf(ch) == Operator;
+    }
+
+    static constexpr bool isIdentifierStart(char ch) {
+        return classOf(ch) >= LetterE;
+    }
+
+    static constexpr bool isIdentifierChar(char ch) {
+        return isIdentifierStart(ch) || classOf(ch) == Zero || classOf(ch) == Digit;
+    }
+
     explicit Lexer(std::string input = {}) : inputText(std::move(input)) {}
 
-    void setInput(std::string input) {
+    // Копирование в уже выделенный буфер: при повторных вызовах память не выделяется
+    void setInput(const std::string& input) {
+        inputText.assign(input);
+        currentPosition = 0;
+        lastType = TokenType::End;
+    }
+
+    void setInput(std::string&& input) {
         inputText = std::move(input);
         currentPosition = 0;
-        lastToken = Token::createEnd();
+        lastType = TokenType::End;
     }
 
+    const std::string& input() const noexcept { return inputText; }
+
     Token getNextToken() {
-        // Пропускаем пробелы
-        advancePastWhitespace();
-        if (currentPosition >= inputText.size()) {
-            lastToken = Token::createEnd();
+        Lexeme lexeme = nextLexeme();
+        switch (lexeme.type) {
+        case TokenType::Number:
+            // Сохраняем исходное представление числа
+            return Token::createNumber(lexeme.value, inputText.substr(lexeme.begin, lexeme.end - lexeme.begin));
+        case TokenType::Identifier:
+            return Token::createIdentifier(inputText.substr(lexeme.begin, lexeme.end - lexeme.begin));
+        case TokenType::Function:
+            return Token::createFunction(inputText.substr(lexeme.begin, lexeme.end - lexeme.begin));
+        case TokenType::Operator:
+            return Token::createOperator(lexeme.op);
+        case TokenType::LeftParen:
+            return Token::createLeftParen();
+        case TokenType::RightParen:
+            return Token::createRightParen();
+        case TokenType::Comma:
+            return Token::createComma();
+        default:
             return Token::createEnd();
         }
+    }
 
-        char currentChar = inputText[currentPosition];
-
-        // Обрабатываем скобки
-        if (currentChar == '(') {
-            currentPosition++;
-            lastToken = Token::createLeftParen();
-            return lastToken;
-        }
-        if (currentChar == ')') {
-            currentPosition++;
-            lastToken = Token::createRightParen();
-            return lastToken;
-        }
-
-        // Обрабатываем операторы
-        if (isValidOperator(currentChar)) {
-            currentPosition++;
-            // Определяем унарный или бинарный минус
-            if (currentChar == '-' && canBeUnaryMinus()) {
-                lastToken = Token::createOperator('~'); 
-                return lastToken;
-            }
-            lastToken = Token::createOperator(currentChar);
-            return lastToken;
+    // Весь оставшийся ввод одним проходом, включая завершающий End.
+    // Ошибка лексера не бросается, а записывается в tokens.error (см. TokenBuffer);
+    // на токене сверх maxTokens разбор прерывается исключением LimitExceeded
+    void tokenizeAll(TokenBuffer& tokens, std::size_t maxTokens = EvaluationLimits::kUnlimited) {
+        tokens.clear();
+        if (inputText.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Lexer error: input too long");
         }
-        // Обрабатываем числа
-        if (std::isdigit(static_cast<unsigned char>(currentChar)) || currentChar == '.') {
-            const char* startPtr = inputText.c_str() + currentPosition;
-            char* endPtr = nullptr;
-
-            // Преобразуем строку в число
-            double numValue = std::strtod(startPtr, &endPtr);
-            if (endPtr == startPtr) {
-                throw std::runtime_error("Lexer error: invalid number");
-            }
-
-            // Сохраняем исходное представление числа
-            size_t charsRead = static_cast<size_t>(endPtr - startPtr);
-            std::string originalText = inputText.substr(currentPosition, charsRead);
-            currentPosition += charsRead;
+        Cursor cursor{ inputText.c_str(), inputText.size(), currentPosition, lastType };
+        tokenizeSpan(cursor, tokens, maxTokens);
+        currentPosition = cursor.position;
+        lastType = cursor.lastType;
+    }
 
-            lastToken = Token::createNumber(numValue, originalText);
-            return lastToken;
-        }
+    // Участок [begin, end) чужого текста, как если бы перед ним стояло начало выражения.
+    // Участок не должен разрезать токен: text[end] - пробел, '*', '/', '^', скобка, запятая или конец строки
+    // (isTokenBoundary). Ищется '(' после имени и за пределами участка, поэтому Function/Identifier те же
+    static void tokenizeRange(const std::string& text, size_t begin, size_t end, TokenBuffer& tokens) {
+        tokens.clear();
+        Cursor cursor{ text.c_str(), end, begin, TokenType::End };
+        tokenizeSpan(cursor, tokens);
+    }
 
-        throw std::runtime_error(std::string("Lexer error: unexpected character '") + currentChar + "'");
+    // Символ, на котором заканчивается любой токен и не начинается продолжение предыдущего
+    static constexpr bool isTokenBoundary(char ch) {
+        const std::uint8_t charClass = classOf(ch);
+        return charClass == Space || charClass == LeftParen || charClass == RightParen || charClass == Comma ||
+               charClass == Operator;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+
+// Запись результатов через std::to_chars: без локали и потоков, в переиспользуемый буфер.
+// По умолчанию - кратчайшая запись, по которой strtod восстанавливает то же значение бит в бит
+enum class NumberFormat {
+    Shortest,   // Кратчайшая точная запись
+    Fixed,      // precision знаков после точки, как %.Nf
+    Precision   // precision значащих цифр, как %.Ng
+};
+
+struct NumberFormatOptions {
+    static constexpr int kMaxPrecision = 100;
+
+    NumberFormat mode{ NumberFormat::Shortest };
+    int precision{ 6 };   // Для Fixed и Precision, ограничивается [0, kMaxPrecision]
+};
+
+// Хватает на любой double в любом режиме: 309 цифр целой части, точка и kMaxPrecision знаков
+inline constexpr std::size_t kMaxFormattedNumber = 512;
+
+// Записывает value в buffer (kMaxFormattedNumber байт), возвращает длину
+inline std::size_t formatNumber(double value, char* buffer, const NumberFormatOptions& options = {}) {
+    const int precision = std::clamp(options.precision, 0, NumberFormatOptions::kMaxPrecision);
+    char* const last = buffer + kMaxFormattedNumber;
+    std::to_chars_result written;
+    switch (options.mode) {
+    case NumberFormat::Fixed:
+        written = std::to_chars(buffer, last, value, std::chars_format::fixed, precision);
+        break;
+    case NumberFormat::Precision:
+        // %.0g печатает одну значащую цифру
+        written = std::to_chars(buffer, last, value, std::chars_format::general, std::max(precision, 1));
+        break;
+    default:
+        written = std::to_chars(buffer, last, value);
+        break;
+    }
+    return static_cast<std::size_t>(written.ptr - buffer);
+}
+
+inline std::string formatNumber(double value, const NumberFormatOptions& options = {}) {
+    char buffer[kMaxFormattedNumber];
+    return std::string(buffer, formatNumber(value, buffer, options));
+}
+
+// Буфер вывода: строки копятся в памяти и уходят в FILE* одним fwrite, когда буфер заполнен.
+// Память выделяется один раз; число форматируется прямо в нее, без промежуточной строки
+class OutputBuffer {
+    std::FILE* stream;
+    std::string storage;   // flushThreshold байт плюс запас на одно число
+    std::size_t used{ 0 };
+    std::size_t flushThreshold;
+
+public:
+    static constexpr std::size_t kDefaultFlushThreshold = 64 * 1024;
+
+    explicit OutputBuffer(std::FILE* output, std::size_t threshold = kDefaultFlushThreshold)
+        : stream(output), storage(std::max<std::size_t>(1, threshold) + kMaxFormattedNumber, '\0'),
+          flushThreshold(std::max<std::size_t>(1, threshold)) {}
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    ~OutputBuffer() { flush(); }
+
+    void append(std::string_view text) {
+        while (!text.empty()) {
+            const std::size_t count = std::min(text.size(), storage.size() - used);
+            text.copy(storage.data() + used, count);
+            used += count;
+            text.remove_prefix(count);
+            if (used >= flushThreshold) flush();
+        }
+    }
+
+    void append(char ch) {
+        storage[used++] = ch;
+        if (used >= flushThreshold) flush();
+    }
+
+    void appendNumber(double value, const NumberFormatOptions& options = {}) {
+        used += formatNumber(value, storage.data() + used, options);
+        if (used >= flushThreshold) flush();
+    }
+
+    void flush() {
+        if (used > 0) std::fwrite(storage.data(), 1, used, stream);
+        used = 0;
+        std::fflush(stream);
+    }
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include "program.h"
+#include "expression_tree.h"
+
+// Настройки оптимизации скомпилированной программы
+struct OptimizerOptions {
+    // fast-math: перестановка скобок в длинных цепочках + и * в сбалансированное дерево.
+    // Меняет порядок округлений, поэтому результат может отличаться в последних разрядах
+    bool reassociate{ false };
+    // Минимальное число операндов цепочки, начиная с которого она перестраивается
+    std::size_t minChainLength{ 4 };
+    // fast-math: деление на любую константу заменяется умножением на 1/c (округляется дважды).
+    // Без флага так заменяется только деление на степень двойки, где результат точный
+    bool reciprocalDivision{ false };
+};
+
+// Проходы оптимизации над деревом выражения
+class Optimizer {
+    // Операнды цепочки одинаковых ассоциативных операций в исходном порядке слева направо
+    static void collectChain(const ExpressionTree& tree, std::uint32_t index, OpCode opCode, std::vector<std::uint32_t>& operands) {
+        std::vector<std::uint32_t> pending{ index };
+        while (!pending.empty()) {
+            std::uint32_t current = pending.back();
+            pending.pop_back();
+            const ExpressionNode& node = tree.nodes[current];
+            if (node.instruction.opCode == opCode) {
+                pending.push_back(node.right);
+                pending.push_back(node.left);
+            }
+            else {
+                operands.push_back(current);
+            }
+        }
+    }
+
+    // Сбалансированное дерево над operands[begin, end): глубина цепочки log2(n) вместо n
+    static std::uint32_t buildBalanced(ExpressionTree& tree, const std::vector<std::uint32_t>& operands,
+                                       std::size_t begin, std::size_t end, OpCode opCode) {
+        if (end - begin == 1) return operands[begin];
+        std::size_t middle = begin + (end - begin) / 2;
+        ExpressionNode node;
+        node.instruction = { opCode, 0 };
+        node.left = buildBalanced(tree, operands, begin, middle, opCode);
+        node.right = buildBalanced(tree, operands, middle, end, opCode);
+        return tree.add(node);
+    }
+
+    // Деление на константу: умножение на обратную величину или DivideConstant без проверки на ноль
+    static void reduceDivisions(ExpressionTree& tree, std::vector<double>& constants, bool reciprocalDivision) {
+        const std::size_t nodeCount = tree.nodes.size();
+        for (std::uint32_t index = 0; index < nodeCount; ++index) {
+            ExpressionNode& node = tree.nodes[index];
+            if (node.instruction.opCode != OpCode::Divide) continue;
+            const Instruction divisorInstruction = tree.nodes[node.right].instruction;
+            if (divisorInstruction.opCode != OpCode::PushConstant) continue;
+
+            const double divisor = constants[divisorInstruction.operand];
+            if (hasExactReciprocal(divisor) || (reciprocalDivision && divisor != 0.0 && std::isfinite(1.0 / divisor))) {
+                ExpressionNode reciprocal;
+                reciprocal.instruction = { OpCode::PushConstant, static_cast<std::uint32_t>(constants.size()) };
+                constants.push_back(1.0 / divisor);
+                const std::uint32_t reciprocalIndex = tree.add(reciprocal);
+                // tree.add мог перевыделить массив узлов
+                tree.nodes[index].instruction = { OpCode::Multiply, 0 };
+                tree.nodes[index].right = reciprocalIndex;
+            }
+            else if (divisor != 0.0) {
+                node.instruction = { OpCode::DivideConstant, divisorInstruction.operand };
+                node.right = ExpressionNode::kNoChild;
+            }
+        }
+    }
+
+    static void reassociate(ExpressionTree& tree, std::size_t minChainLength) {
+        // Родитель каждого узла нужен, чтобы найти корни цепочек
+        std::vector<std::uint32_t> parents(tree.nodes.size(), ExpressionNode::kNoChild);
+        for (std::uint32_t index = 0; index < tree.nodes.size(); ++index) {
+            const ExpressionNode& node = tree.nodes[index];
+            if (node.left != ExpressionNode::kNoChild) parents[node.left] = index;
+            if (node.right != ExpressionNode::kNoChild) parents[node.right] = index;
+        }
+
+        std::vector<std::uint32_t> operands;
+        for (std::uint32_t index : tree.postOrder(tree.root)) {
+            OpCode opCode = tree.nodes[index].instruction.opCode;
+            if (!ExpressionTree::isCommutative(opCode)) continue;
+            std::uint32_t parent = parents[index];
+            if (parent != ExpressionNode::kNoChild && tree.nodes[parent].instruction.opCode == opCode) continue;
+
+            operands.clear();
+            collectChain(tree, index, opCode, operands);
+            if (operands.size() < minChainLength) continue;
+
+            std::uint32_t balanced = buildBalanced(tree, operands, 0, operands.size(), opCode);
+            // Новый корень цепочки занимает место старого
+            if (parent == ExpressionNode::kNoChild) tree.root = balanced;
+            else if (tree.nodes[parent].left == index) tree.nodes[parent].left = balanced;
+            else tree.nodes[parent].right = balanced;
+        }
+    }
+
+public:
+    static Program optimize(const Program& program, const OptimizerOptions& options) {
+        Program optimized;
+        optimized.constants = program.constants;
+        optimized.variables = program.variables;
+
+        ExpressionTree tree = ExpressionTree::build(program);
+        reduceDivisions(tree, optimized.constants, options.reciprocalDivision);
+        if (options.reassociate) reassociate(tree, options.minChainLength);
+
+        optimized.code = tree.emit(true);
+        optimized.stackDepth = computeStackDepth(optimized.code);
+        return optimized;
+    }
+};
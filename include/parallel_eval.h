@@ -0,0 +1,180 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include "token.h"
+#include "functions.h"
+#include "translator.h"
+#include "thread_pool.h"
+
+// Вычисление одного очень большого RPN на нескольких потоках; результат побитово совпадает с Eval::evaluateRpn.
+//  1. Высота стека после каждого токена - параллельная префиксная сумма (+1 операнд, 0 унарный, -1 бинарный).
+//     Провал ниже единицы или итог не 1 - вычисление отдается Eval, чтобы ошибка была та же.
+//  2. В поддереве [begin, end] токены с высотой, равной высоте end, образуют его левый хребет:
+//     первый лист, затем узлы, каждый из которых применяется к значению предыдущего. Между соседними
+//     узлами хребта лежит правый операнд второго из них (пусто у унарного) - независимое поддерево.
+//  3. Правые операнды вычисляются параллельно (большие - рекурсивно, до kMaxNesting уровней),
+//     затем хребет сворачивается по порядку. Порядок операций внутри поддеревьев не меняется.
+// Любая ошибка на параллельном пути повторяется последовательным вычислением ради того же сообщения
+class ParallelEval {
+    ThreadPool& pool;
+    std::size_t grain;
+    Eval sequential;
+    std::vector<std::int32_t> heights;  // Высота стека после токена (на первом проходе - ее изменение)
+
+    std::size_t blockCount(std::size_t count) const {
+        return std::max<std::size_t>(1, std::min((pool.size() + 1) * 4, count / std::max<std::size_t>(1, grain / 4) + 1));
+    }
+
+    // Изменение высоты стека; false - токен, которого Eval не примет
+    static bool heightDelta(const Token& token, std::int32_t& delta) {
+        switch (token.type) {
+        case TokenType::Number:
+        case TokenType::Identifier:
+            delta = 1;
+            return true;
+        case TokenType::Operator:
+            delta = token.getOperatorChar() == '~' ? 0 : -1;
+            return true;
+        case TokenType::Function: {
+            const MathFunctionInfo* function = findMathFunction(token.content);
+            if (!function) return false;
+            delta = 1 - static_cast<std::int32_t>(function->arity);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    // Возвращает false, если RPN не является одним законченным выражением
+    bool computeHeights(const std::vector<Token>& rpn) {
+        const std::size_t count = rpn.size();
+        const std::size_t blocks = blockCount(count);
+        const std::size_t blockSize = (count + blocks - 1) / blocks;
+        std::vector<std::int64_t> sums(blocks, 0), minimums(blocks, 0);
+        std::vector<char> valid(blocks, 1);
+        heights.resize(count);
+
+        pool.parallelFor(blocks, [&](std::size_t first, std::size_t last) {
+            for (std::size_t block = first; block < last; ++block) {
+                std::int64_t sum = 0, minimum = std::numeric_limits<std::int64_t>::max();
+                for (std::size_t i = block * blockSize, end = std::min(count, (block + 1) * blockSize); i < end; ++i) {
+                    std::int32_t delta = 0;
+                    if (!heightDelta(rpn[i], delta)) {
+                        valid[block] = 0;
+                        break;
+                    }
+                    heights[i] = delta;
+                    sum += delta;
+                    minimum = std::min(minimum, sum);
+                }
+                sums[block] = sum;
+                minimums[block] = std::min(minimum, sum);  // Пустой блок ничего не меняет
+            }
+        });
+
+        // Смещения блоков; проверка, что на стеке всегда есть хотя бы одно значение
+        std::vector<std::int64_t> starts(blocks, 0);
+        std::int64_t running = 0;
+        for (std::size_t block = 0; block < blocks; ++block) {
+            if (!valid[block] || running + minimums[block] < 1) return false;
+            starts[block] = running;
+            running += sums[block];
+        }
+        if (running != 1) return false;
+
+        pool.parallelFor(blocks, [&](std::size_t first, std::size_t last) {
+            for (std::size_t block = first; block < last; ++block) {
+                std::int64_t height = starts[block];
+                for (std::size_t i = block * blockSize, end = std::min(count, (block + 1) * blockSize); i < end; ++i) {
+                    height += heights[i];
+                    heights[i] = static_cast<std::int32_t>(height);
+                }
+            }
+        });
+        return true;
+    }
+
+    // Узлы хребта поддерева [begin, end]: токены с высотой стека, как у его корня
+    std::vector<std::size_t> findSpine(std::size_t begin, std::size_t end) {
+        const std::int32_t level = heights[end];
+        const std::size_t count = end - begin + 1;
+        const std::size_t blocks = blockCount(count);
+        const std::size_t blockSize = (count + blocks - 1) / blocks;
+        std::vector<std::vector<std::size_t>> found(blocks);
+        pool.parallelFor(blocks, [&](std::size_t first, std::size_t last) {
+            for (std::size_t block = first; block < last; ++block) {
+                for (std::size_t i = begin + block * blockSize, stop = std::min(end + 1, begin + (block + 1) * blockSize); i < stop; ++i) {
+                    if (heights[i] == level) found[block].push_back(i);
+                }
+            }
+        });
+        std::vector<std::size_t> spine;
+        for (const std::vector<std::size_t>& part : found) spine.insert(spine.end(), part.begin(), part.end());
+        return spine;
+    }
+
+    static double evaluateSequential(const std::vector<Token>& rpn, std::size_t begin, std::size_t end) {
+        static thread_local Eval evaluator;
+        return evaluator.evaluateRange(rpn.data() + begin, rpn.data() + end + 1);
+    }
+
+    double evaluateSubtree(const std::vector<Token>& rpn, std::size_t begin, std::size_t end, std::size_t nesting) {
+        // Глубокая правая рекурсия вычисляется последовательно, как и малые поддеревья
+        if (end - begin + 1 < grain || nesting > kMaxNesting) return evaluateSequential(rpn, begin, end);
+
+        const std::vector<std::size_t> spine = findSpine(begin, end);
+        // operands[k] - правый операнд узла spine[k]; малые операнды собираются в куски около grain токенов
+        std::vector<double> operands(spine.size(), 0.0);
+        const std::size_t minChunk = std::max<std::size_t>(1, spine.size() * grain / (end - begin + 1));
+        pool.parallelFor(spine.size() - 1, [&](std::size_t first, std::size_t last) {
+            for (std::size_t k = first + 1; k <= last; ++k) {
+                const std::size_t operandBegin = spine[k - 1] + 1, operandEnd = spine[k];
+                if (operandBegin == operandEnd) continue;
+                operands[k] = operandEnd - operandBegin >= grain
+                    ? evaluateSubtree(rpn, operandBegin, operandEnd - 1, nesting + 1)
+                    : evaluateSequential(rpn, operandBegin, operandEnd - 1);
+            }
+        }, minChunk);
+
+        // Свертка хребта в исходном порядке, теми же операциями, что и в Eval
+        double value = evaluateSequential(rpn, begin, begin);
+        for (std::size_t k = 1; k < spine.size(); ++k) {
+            const Token& token = rpn[spine[k]];
+            const bool unary = spine[k - 1] + 1 == spine[k];
+            if (token.type == TokenType::Function) {
+                const MathFunctionInfo* function = findMathFunction(token.content);
+                value = applyMathFunction(function->id, value, unary ? 0.0 : operands[k]);
+            }
+            else if (unary) {
+                value = -value;
+            }
+            else {
+                const bool rightIsLiteral = rpn[spine[k] - 1].type == TokenType::Number;
+                value = Eval::applyOperator(token.getOperatorChar(), value, operands[k], rightIsLiteral);
+            }
+        }
+        return value;
+    }
+
+public:
+    static constexpr std::size_t kDefaultGrain = 16384;
+    static constexpr std::size_t kMaxNesting = 32;
+
+    explicit ParallelEval(ThreadPool& workers, std::size_t grainTokens = kDefaultGrain)
+        : pool(workers), grain(std::max<std::size_t>(1, grainTokens)) {}
+
+    double evaluateRpn(const std::vector<Token>& rpn) {
+        if (rpn.size() <= grain || !computeHeights(rpn)) return sequential.evaluateRpn(rpn);
+        try {
+            return evaluateSubtree(rpn, 0, rpn.size() - 1, 0);
+        }
+        catch (const std::runtime_error&) {
+            return sequential.evaluateRpn(rpn);
+        }
+    }
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include "lexer.h"
+#include "thread_pool.h"
+
+// Разбор на токены одного очень большого выражения на нескольких потоках.
+// Ввод режется на куски по границам токенов (Lexer::isTokenBoundary), каждый кусок разбирается отдельно,
+// затем куски склеиваются. От предыдущего куска зависит только то, унарный ли минус стоит в начале куска:
+// кусок разбирается как начало выражения, а при склейке '~' меняется на '-', если перед ним был операнд.
+// Результат совпадает с Lexer::tokenizeAll, включая смещения и ошибку
+class ParallelLexer {
+    ThreadPool& pool;
+    std::size_t chunkBytes;
+    // Буферы кусков переиспользуются между вызовами, как рабочие буферы Parcer
+    std::vector<TokenBuffer> parts;
+
+public:
+    static constexpr std::size_t kDefaultChunkBytes = std::size_t(1) << 20;
+
+    explicit ParallelLexer(ThreadPool& workers, std::size_t bytesPerChunk = kDefaultChunkBytes)
+        : pool(workers), chunkBytes(std::max<std::size_t>(1, bytesPerChunk)) {}
+
+    void tokenizeAll(const std::string& input, TokenBuffer& tokens) {
+        if (input.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Lexer error: input too long");
+        }
+
+        // Куски начинаются на символе-границе; если его не нашлось до конца, кусок тянется до конца ввода
+        std::vector<std::size_t> bounds{ 0 };
+        for (std::size_t target = chunkBytes; target < input.size();) {
+            std::size_t split = target;
+            while (split < input.size() && !Lexer::isTokenBoundary(input[split])) split++;
+            if (split >= input.size()) break;
+            bounds.push_back(split);
+            target = split + chunkBytes;
+        }
+        bounds.push_back(input.size());
+        const std::size_t chunkCount = bounds.size() - 1;
+
+        if (parts.size() < chunkCount) parts.resize(chunkCount);
+        pool.parallelFor(chunkCount, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t chunk = begin; chunk < end; ++chunk) {
+                Lexer::tokenizeRange(input, bounds[chunk], bounds[chunk + 1], parts[chunk]);
+            }
+        });
+
+        // Сколько токенов дает каждый кусок: End промежуточного куска отбрасывается, после куска с ошибкой - ничего
+        std::vector<std::size_t> starts(chunkCount + 1, 0);
+        std::size_t usedChunks = chunkCount;
+        TokenType previousType = TokenType::End;
+        for (std::size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            TokenBuffer& part = parts[chunk];
+            const bool failed = !part.error.empty();
+            const std::size_t taken = part.size() - (failed || chunk + 1 == chunkCount ? 0 : 1);
+            starts[chunk + 1] = starts[chunk] + taken;
+
+            // Поправка унарного минуса по последнему токену предыдущих кусков
+            if (part.types[0] == TokenType::Operator && part.operators[0] == '~' && !Lexer::canBeUnaryMinus(previousType)) {
+                part.operators[0] = '-';
+            }
+            if (taken > 0) previousType = part.types[taken - 1];
+            if (failed) {
+                usedChunks = chunk + 1;
+                break;
+            }
+        }
+
+        const std::size_t total = starts[usedChunks];
+        tokens.clear();
+        tokens.types.resize(total);
+        tokens.operators.resize(total);
+        tokens.values.resize(total);
+        tokens.offsets.resize(total);
+        tokens.lengths.resize(total);
+        tokens.error = parts[usedChunks - 1].error;
+        pool.parallelFor(usedChunks, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t chunk = begin; chunk < end; ++chunk) {
+                const TokenBuffer& part = parts[chunk];
+                const std::size_t count = starts[chunk + 1] - starts[chunk];
+                const std::size_t at = starts[chunk];
+                std::copy_n(part.types.begin(), count, tokens.types.begin() + at);
+                std::copy_n(part.operators.begin(), count, tokens.operators.begin() + at);
+                std::copy_n(part.values.begin(), count, tokens.values.begin() + at);
+                std::copy_n(part.offsets.begin(), count, tokens.offsets.begin() + at);
+                std::copy_n(part.lengths.begin(), count, tokens.lengths.begin() + at);
+            }
+        });
+    }
+};
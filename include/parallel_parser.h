@@ -0,0 +1,260 @@
+#pragma once
+#include <vector>
+#include <string_view>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include "token.h"
+#include "parser.h"
+#include "thread_pool.h"
+
+// Разбор одного очень большого выражения на нескольких потоках; RPN совпадает с Parcer::toRpn.
+//  1. Глубина скобок перед каждым токеном - параллельная префиксная сумма (+1 за '(', -1 за ')').
+//     Отрицательная глубина или ненулевой итог - разбор отдается Parcer, чтобы ошибка была та же.
+//  2. Пары скобок: каждый блок сопоставляет свои скобки стеком, непарные остатки блоков сводятся по порядку.
+//  3. Выражение режется на слагаемые по '+'/'-' своего уровня скобок, слагаемые - на множители по '*'/'/'.
+//     Бинарный оператор наименьшего приоритета выталкивает из стека все операторы уровня, поэтому
+//     RPN = RPN(t0) RPN(t1) op0 RPN(t2) op1 ...; куски слагаемых разбираются параллельно и склеиваются.
+//     '^' не режется: он правоассоциативен и связывает сильнее унарного минуса.
+//     Выражение целиком в скобках разбирается как его содержимое (до kMaxNesting уровней), остальное - последовательно.
+// Любая ошибка на параллельном пути повторяется последовательным разбором ради того же сообщения
+class ParallelParser {
+    enum class Level { Sum, Product, Group };
+
+    ThreadPool& pool;
+    std::size_t grain;
+    Parcer sequential;
+    std::vector<std::int32_t> depths;    // Глубина скобок перед токеном
+    std::vector<std::uint32_t> matches;  // Для '(' - индекс парной ')'
+    std::vector<Token> outputQueue;
+
+    std::size_t blockCount(std::size_t count) const {
+        return std::max<std::size_t>(1, std::min((pool.size() + 1) * 4, count / std::max<std::size_t>(1, grain / 4) + 1));
+    }
+
+    // Возвращает false, если скобки не сбалансированы
+    bool computeDepths(const TokenBuffer& tokens) {
+        const std::size_t count = tokens.size();
+        const std::size_t blocks = blockCount(count);
+        const std::size_t blockSize = (count + blocks - 1) / blocks;
+        std::vector<std::int64_t> sums(blocks, 0), minimums(blocks, 0);
+        depths.resize(count);
+
+        auto delta = [&tokens](std::size_t index) -> std::int64_t {
+            const TokenType type = tokens.types[index];
+            return type == TokenType::LeftParen ? 1 : (type == TokenType::RightParen ? -1 : 0);
+        };
+        pool.parallelFor(blocks, [&](std::size_t first, std::size_t last) {
+            for (std::size_t block = first; block < last; ++block) {
+                std::int64_t sum = 0, minimum = 0;
+                for (std::size_t i = block * blockSize, end = std::min(count, (block + 1) * blockSize); i < end; ++i) {
+                    sum += delta(i);
+                    minimum = std::min(minimum, sum);
+                }
+                sums[block] = sum;
+                minimums[block] = minimum;
+            }
+        });
+
+        // Смещения блоков; проверка, что глубина нигде не уходит ниже нуля
+        std::vector<std::int64_t> starts(blocks, 0);
+        std::int64_t running = 0;
+        for (std::size_t block = 0; block < blocks; ++block) {
+            if (running + minimums[block] < 0) return false;
+            starts[block] = running;
+            running += sums[block];
+        }
+        if (running != 0) return false;
+
+        pool.parallelFor(blocks, [&](std::size_t first, std::size_t last) {
+            for (std::size_t block = first; block < last; ++block) {
+                std::int64_t depth = starts[block];
+                for (std::size_t i = block * blockSize, end = std::min(count, (block + 1) * blockSize); i < end; ++i) {
+                    depths[i] = static_cast<std::int32_t>(depth);
+                    depth += delta(i);
+                }
+            }
+        });
+        return true;
+    }
+
+    // Скобки уже сбалансированы (computeDepths)
+    void matchParentheses(const TokenBuffer& tokens) {
+        const std::size_t count = tokens.size();
+        const std::size_t blocks = blockCount(count);
+        const std::size_t blockSize = (count + blocks - 1) / blocks;
+        std::vector<std::vector<std::uint32_t>> openLeft(blocks), closeLeft(blocks);
+        matches.resize(count);
+
+        pool.parallelFor(blocks, [&](std::size_t first, std::size_t last) {
+            for (std::size_t block = first; block < last; ++block) {
+                std::vector<std::uint32_t>& open = openLeft[block];
+                for (std::size_t i = block * blockSize, end = std::min(count, (block + 1) * blockSize); i < end; ++i) {
+                    if (tokens.types[i] == TokenType::LeftParen) {
+                        open.push_back(static_cast<std::uint32_t>(i));
+                    }
+                    else if (tokens.types[i] == TokenType::RightParen) {
+                        if (open.empty()) {
+                            closeLeft[block].push_back(static_cast<std::uint32_t>(i));
+                        }
+                        else {
+                            matches[open.back()] = static_cast<std::uint32_t>(i);
+                            open.pop_back();
+                        }
+                    }
+                }
+            }
+        });
+
+        // Непарные ')' блока закрывают непарные '(' предыдущих блоков
+        std::vector<std::uint32_t> pending;
+        for (std::size_t block = 0; block < blocks; ++block) {
+            for (std::uint32_t close : closeLeft[block]) {
+                matches[pending.back()] = close;
+                pending.pop_back();
+            }
+            pending.insert(pending.end(), openLeft[block].begin(), openLeft[block].end());
+        }
+    }
+
+    // Операторы op1/op2 на уровне скобок begin внутри [begin, end)
+    std::vector<std::size_t> findSplits(const TokenBuffer& tokens, std::size_t begin, std::size_t end, char op1, char op2) {
+        const std::int32_t level = depths[begin];
+        auto isSplit = [&](std::size_t i) {
+            return tokens.types[i] == TokenType::Operator && depths[i] == level &&
+                   (tokens.operators[i] == op1 || tokens.operators[i] == op2);
+        };
+        const std::size_t count = end - begin;
+        const std::size_t blocks = blockCount(count);
+        const std::size_t blockSize = (count + blocks - 1) / blocks;
+        std::vector<std::vector<std::size_t>> found(blocks);
+        pool.parallelFor(blocks, [&](std::size_t first, std::size_t last) {
+            for (std::size_t block = first; block < last; ++block) {
+                for (std::size_t i = begin + block * blockSize, stop = std::min(end, begin + (block + 1) * blockSize); i < stop; ++i) {
+                    if (isSplit(i)) found[block].push_back(i);
+                }
+            }
+        });
+        std::vector<std::size_t> splits;
+        for (const std::vector<std::size_t>& part : found) splits.insert(splits.end(), part.begin(), part.end());
+        return splits;
+    }
+
+    static void parseSequential(const TokenBuffer& tokens, std::string_view source, std::size_t begin, std::size_t end, std::vector<Token>& output) {
+        static thread_local Parcer parser;
+        parser.parseRange(tokens, source, begin, end, output);
+    }
+
+    void parseExpression(const TokenBuffer& tokens, std::string_view source, std::size_t begin, std::size_t end, Level level,
+                         std::size_t nesting, std::vector<Token>& output) {
+        // Глубокая вложенность скобок разбирается последовательно: иначе рекурсия и повторные проходы по диапазону
+        if (end - begin < grain || nesting > kMaxNesting) {
+            parseSequential(tokens, source, begin, end, output);
+            return;
+        }
+        switch (level) {
+        case Level::Sum:
+        case Level::Product: {
+            std::vector<std::size_t> splits = level == Level::Sum ? findSplits(tokens, begin, end, '+', '-') : findSplits(tokens, begin, end, '*', '/');
+            const Level next = level == Level::Sum ? Level::Product : Level::Group;
+            if (splits.empty()) {
+                parseExpression(tokens, source, begin, end, next, nesting, output);
+                return;
+            }
+            parseSequence(tokens, source, begin, end, splits, next, nesting, output);
+            return;
+        }
+        case Level::Group:
+            if (tokens.types[begin] == TokenType::LeftParen && matches[begin] == end - 1) {
+                parseExpression(tokens, source, begin + 1, end - 1, Level::Sum, nesting + 1, output);
+                return;
+            }
+            parseSequential(tokens, source, begin, end, output);
+            return;
+        }
+    }
+
+    // Сколько токенов диапазона попадет в RPN: все, кроме скобок и запятых
+    static std::size_t rpnLength(const TokenBuffer& tokens, std::size_t begin, std::size_t end) {
+        std::size_t length = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            const TokenType type = tokens.types[i];
+            length += type != TokenType::LeftParen && type != TokenType::RightParen && type != TokenType::Comma;
+        }
+        return length;
+    }
+
+    // Части между splits: RPN(t0) RPN(t1) op0 RPN(t2) op1 ...
+    // Подряд идущие малые части собираются в кусок не меньше grain токенов и разбираются одним вызовом:
+    // "tk opk ... tm" дает RPN(tk) RPN(tk+1) opk ..., не хватает только op(k-1) сразу после RPN(tk).
+    // Большая часть - отдельный кусок и разбирается рекурсивно
+    void parseSequence(const TokenBuffer& tokens, std::string_view source, std::size_t begin, std::size_t end,
+                       const std::vector<std::size_t>& splits, Level next, std::size_t nesting, std::vector<Token>& output) {
+        const std::size_t partCount = splits.size() + 1;
+        auto partBegin = [&](std::size_t part) { return part == 0 ? begin : splits[part - 1] + 1; };
+        auto partEnd = [&](std::size_t part) { return part == splits.size() ? end : splits[part]; };
+
+        std::vector<std::size_t> chunkStarts{ 0 };
+        for (std::size_t part = 0; part < partCount; ++part) {
+            const bool large = partEnd(part) - partBegin(part) >= grain;
+            if (large && part != chunkStarts.back()) chunkStarts.push_back(part);
+            if (large || partEnd(part) - partBegin(chunkStarts.back()) >= grain) chunkStarts.push_back(part + 1);
+        }
+        if (chunkStarts.back() != partCount) chunkStarts.push_back(partCount);
+
+        std::vector<std::vector<Token>> chunkOutputs(chunkStarts.size() - 1);
+        pool.parallelFor(chunkOutputs.size(), [&](std::size_t first, std::size_t last) {
+            for (std::size_t chunk = first; chunk < last; ++chunk) {
+                std::vector<Token>& chunkOutput = chunkOutputs[chunk];
+                const std::size_t firstPart = chunkStarts[chunk];
+                const std::size_t lastPart = chunkStarts[chunk + 1] - 1;
+                if (firstPart == lastPart) {
+                    parseExpression(tokens, source, partBegin(firstPart), partEnd(firstPart), next, nesting, chunkOutput);
+                    if (firstPart > 0) chunkOutput.push_back(Parcer::makeToken(tokens, source, splits[firstPart - 1]));
+                    continue;
+                }
+                parseSequential(tokens, source, partBegin(firstPart), partEnd(lastPart), chunkOutput);
+                if (firstPart > 0) {
+                    const std::size_t at = rpnLength(tokens, partBegin(firstPart), partEnd(firstPart));
+                    chunkOutput.insert(chunkOutput.begin() + static_cast<std::ptrdiff_t>(at), Parcer::makeToken(tokens, source, splits[firstPart - 1]));
+                }
+            }
+        });
+
+        // Куски переносятся в output параллельно, каждый на свое место
+        std::vector<std::size_t> offsets(chunkOutputs.size() + 1, output.size());
+        for (std::size_t chunk = 0; chunk < chunkOutputs.size(); ++chunk) offsets[chunk + 1] = offsets[chunk] + chunkOutputs[chunk].size();
+        output.resize(offsets.back());
+        pool.parallelFor(chunkOutputs.size(), [&](std::size_t first, std::size_t last) {
+            for (std::size_t chunk = first; chunk < last; ++chunk) {
+                std::move(chunkOutputs[chunk].begin(), chunkOutputs[chunk].end(), output.begin() + static_cast<std::ptrdiff_t>(offsets[chunk]));
+            }
+        });
+    }
+
+public:
+    static constexpr std::size_t kDefaultGrain = 16384;
+    static constexpr std::size_t kMaxNesting = 32;
+
+    explicit ParallelParser(ThreadPool& workers, std::size_t grainTokens = kDefaultGrain)
+        : pool(workers), grain(std::max<std::size_t>(1, grainTokens)) {}
+
+    // Результат ссылается на внутренний буфер и действителен до следующего вызова toRpn
+    const std::vector<Token>& toRpn(const TokenBuffer& tokens, std::string_view source) {
+        if (!tokens.error.empty() || tokens.size() <= grain || !computeDepths(tokens)) {
+            return sequential.toRpn(tokens, source);
+        }
+        matchParentheses(tokens);
+        outputQueue.clear();
+        outputQueue.reserve(tokens.size());
+        try {
+            parseExpression(tokens, source, 0, tokens.size() - 1, Level::Sum, 0, outputQueue);
+        }
+        catch (const std::runtime_error&) {
+            return sequential.toRpn(tokens, source);
+        }
+        return outputQueue;
+    }
+};
@@ -1,71 +1,154 @@
 #pragma once
 #include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
 #include <stdexcept>
 #include "token.h"
 #include "stack.h"
 #include "lexer.h"
+#include "functions.h"
+#include "evaluation_limits.h"
 
 // Преобразование инфиксной нотации в RPN (алгоритм Shunting Yard)
 class Parcer {
-    static int getPrecedence(const Token& token) {
-        if (token.type != TokenType::Operator) return -1;
-        switch (token.getOperatorChar()) {
-        case '+': case '-': return 1;
-        case '*': case '/': return 2;
-        case '~': return 3;
-        default: return -1;
-        }
+    // Рабочие буферы переиспользуются между вызовами (очищаются, но не освобождаются)
+    std::vector<Token> outputQueue;
+    TokenBuffer tokenBuffer;
+    // Стек операторов хранит индексы токенов в TokenBuffer
+    ds::Stack<std::uint32_t> operatorStack;
+    // Для каждой открытой скобки: число аргументов вызова функции или 0 для обычной скобки
+    ds::Stack<std::size_t> argumentCounts;
+    std::size_t scratchLimit{ kDefaultScratchLimit };
+    EvaluationLimits limits;
+
+    // Освобождаем память, если предыдущий ввод раздул буферы выше порога
+    void resetScratch() {
+        outputQueue.clear();
+        operatorStack.clear();
+        argumentCounts.clear();
+        if (outputQueue.capacity() > scratchLimit) outputQueue.shrink_to_fit();
+        if (operatorStack.capacity() > scratchLimit) operatorStack.shrink_to_fit();
+        if (argumentCounts.capacity() > scratchLimit) argumentCounts.shrink_to_fit();
+    }
+
+    // Каждый рост стека операторов проверяется на лимит глубины
+    void pushOperator(std::size_t index) {
+        if (operatorStack.size() >= limits.maxStackDepth) throw LimitExceeded(LimitKind::StackDepth, limits.maxStackDepth);
+        operatorStack.push(static_cast<std::uint32_t>(index));
     }
 
-    static bool isRightAssociative(const Token& token) {
-        return (token.type == TokenType::Operator && token.getOperatorChar() == '~');
+    static std::string_view tokenText(const TokenBuffer& tokens, std::string_view source, std::size_t index) {
+        return source.substr(tokens.offsets[index], tokens.lengths[index]);
     }
 
 public:
-    std::vector<Token> toRpn(Lexer& lex) {
-        std::vector<Token> outputQueue;
-        ds::Stack<Token> operatorStack;
+    static constexpr std::size_t kDefaultScratchLimit = 4096;
+
+    // Максимальная емкость буферов (в токенах), которая сохраняется между вызовами
+    void setScratchLimit(std::size_t maxTokens) { scratchLimit = maxTokens; }
+    std::size_t getScratchLimit() const noexcept { return scratchLimit; }
+
+    // Лимиты на длину ввода, число токенов, глубину скобок и стека (см. EvaluationLimits)
+    void setLimits(const EvaluationLimits& newLimits) { limits = newLimits; }
+    const EvaluationLimits& getLimits() const noexcept { return limits; }
+
+    // Оставшийся ввод лексера разбирается целиком в буфер токенов, затем по индексам.
+    // Результат ссылается на внутренний буфер и действителен до следующего вызова toRpn
+    const std::vector<Token>& toRpn(Lexer& lex) {
+        if (lex.input().size() > limits.maxInputBytes) throw LimitExceeded(LimitKind::InputBytes, limits.maxInputBytes);
+        if (tokenBuffer.capacity() > scratchLimit) {
+            tokenBuffer.clear();
+            tokenBuffer.shrink_to_fit();
+        }
+        lex.tokenizeAll(tokenBuffer, limits.maxTokens);
+        return toRpn(tokenBuffer, lex.input());
+    }
+
+    // Токен для выходной очереди: строка содержимого строится только здесь
+    static Token makeToken(const TokenBuffer& tokens, std::string_view source, std::size_t index) {
+        switch (tokens.types[index]) {
+        case TokenType::Number:
+            return Token::createNumber(tokens.values[index], std::string(tokenText(tokens, source, index)));
+        case TokenType::Identifier:
+            return Token::createIdentifier(std::string(tokenText(tokens, source, index)));
+        case TokenType::Function:
+            return Token::createFunction(std::string(tokenText(tokens, source, index)));
+        default:
+            return Token::createOperator(tokens.operators[index]);
+        }
+    }
+
+    // Разбор готового буфера токенов; source - строка, которую разбирал лексер
+    const std::vector<Token>& toRpn(const TokenBuffer& tokens, std::string_view source) {
+        // Буфер без завершающего End (не от tokenizeAll): выражение кончилось, не начавшись
+        if (tokens.empty()) throw std::runtime_error(tokens.error.empty() ? "Parser error: operand expected" : tokens.error);
+        resetScratch();
+        outputQueue.reserve(tokens.size());
+        parseRange(tokens, source, 0, tokens.size() - 1, outputQueue);
+        return outputQueue;
+    }
+
+    // Токены [begin, end) как отдельное выражение (на end - конец выражения); RPN дописывается в output
+    void parseRange(const TokenBuffer& tokens, std::string_view source, std::size_t begin, std::size_t end, std::vector<Token>& output) {
+        operatorStack.clear();
+        argumentCounts.clear();
 
         enum ParseState { ExpectingOperand, ExpectingOperator };
         ParseState currentState = ExpectingOperand;
 
-        for (;;) {
-            Token currentToken = lex.getNextToken();
+        for (std::size_t index = begin;; ++index) {
+            const TokenType currentType = index == end ? TokenType::End : tokens.types[index];
+            // Ошибка лексера стоит на последнем токене буфера
+            const bool lexerErrorHere = currentType == TokenType::End && index + 1 == tokens.size() && !tokens.error.empty();
 
             // Ожидаем операнд: число, скобку или унарный оператор
             if (currentState == ExpectingOperand) {
-                if (currentToken.type == TokenType::Number) {
-                    // Число сразу в выходную очередь
-                    outputQueue.push_back(currentToken);
+                if (currentType == TokenType::Number || currentType == TokenType::Identifier) {
+                    // Число или переменная сразу в выходную очередь
+                    output.push_back(makeToken(tokens, source, index));
                     currentState = ExpectingOperator;
                     continue;
                 }
-                if (currentToken.type == TokenType::LeftParen) {
-                    // Открывающая скобка в стек
-                    operatorStack.push(currentToken);
+                if (currentType == TokenType::LeftParen) {
+                    // Открывающая скобка в стек; скобка вызова функции начинает счет аргументов
+                    bool isCall = !operatorStack.empty() && tokens.types[operatorStack.top()] == TokenType::Function;
+                    if (argumentCounts.size() >= limits.maxNesting) throw LimitExceeded(LimitKind::Nesting, limits.maxNesting);
+                    argumentCounts.push(isCall ? 1 : 0);
+                    pushOperator(index);
                     currentState = ExpectingOperand;
                     continue;
                 }
-                if (currentToken.type == TokenType::Operator && currentToken.getOperatorChar() == '~') {
+                if (currentType == TokenType::Function) {
+                    // Функция в стек до закрывающей скобки ее аргументов (лексер гарантирует '(' следом)
+                    if (!findMathFunction(tokenText(tokens, source, index))) {
+                        throw std::runtime_error("Parser error: unknown function '" + std::string(tokenText(tokens, source, index)) + "'");
+                    }
+                    pushOperator(index);
+                    currentState = ExpectingOperand;
+                    continue;
+                }
+                if (currentType == TokenType::Operator && tokens.operators[index] == '~') {
                     // Унарный минус в стек
-                    operatorStack.push(currentToken);
+                    pushOperator(index);
                     currentState = ExpectingOperand;
                     continue;
                 }
+                if (lexerErrorHere) throw std::runtime_error(tokens.error);
                 throw std::runtime_error("Parser error: operand expected");
             }
             // Обрабатываем бинарный оператор
-            if (currentToken.type == TokenType::Operator) {
+            if (currentType == TokenType::Operator) {
+                const char currentOperator = tokens.operators[index];
+                const int currentPrec = operatorPrecedence(currentOperator);
                 // Выталкиваем операторы с большим или равным приоритетом
-                while (!operatorStack.empty() && operatorStack.top().type == TokenType::Operator) {
-                    const Token& stackTop = operatorStack.top();
-
-                    int stackPrec = getPrecedence(stackTop);
-                    int currentPrec = getPrecedence(currentToken);
+                while (!operatorStack.empty() && tokens.types[operatorStack.top()] == TokenType::Operator) {
+                    const std::uint32_t stackTop = operatorStack.top();
+                    int stackPrec = operatorPrecedence(tokens.operators[stackTop]);
 
                     // Выталкиваем, если приоритет выше или равен (для левоассоциативных)
-                    if (stackPrec > currentPrec || (stackPrec == currentPrec && !isRightAssociative(currentToken))) {
-                        outputQueue.push_back(stackTop);
+                    if (stackPrec > currentPrec || (stackPrec == currentPrec && !isRightAssociativeOperator(currentOperator))) {
+                        output.push_back(makeToken(tokens, source, stackTop));
                         operatorStack.pop();
                     }
                     else {
@@ -73,48 +156,75 @@ public:
                     }
                 }
                 // Кладем текущий оператор в стек
-                operatorStack.push(currentToken);
+                pushOperator(index);
                 currentState = ExpectingOperand;
                 continue;
             }
 
             // Обрабатываем закрывающую скобку
-            if (currentToken.type == TokenType::RightParen) {
+            if (currentType == TokenType::RightParen) {
                 bool matchingLeftFound = false;
                 // Выталкиваем операторы до открывающей скобки
                 while (!operatorStack.empty()) {
-                    Token stackTop = operatorStack.top();
+                    std::uint32_t stackTop = operatorStack.top();
                     operatorStack.pop();
 
-                    if (stackTop.type == TokenType::LeftParen) {
+                    if (tokens.types[stackTop] == TokenType::LeftParen) {
                         matchingLeftFound = true;
                         break;
                     }
-                    outputQueue.push_back(stackTop);
+                    output.push_back(makeToken(tokens, source, stackTop));
                 }
                 if (!matchingLeftFound) throw std::runtime_error("Parser error: ')' without matching '('");
+
+                // Закрывающая скобка вызова: функция в выходную очередь с проверкой числа аргументов
+                std::size_t argumentCount = argumentCounts.top();
+                argumentCounts.pop();
+                if (argumentCount > 0) {
+                    const std::uint32_t functionIndex = operatorStack.top();
+                    const std::string_view name = tokenText(tokens, source, functionIndex);
+                    const MathFunctionInfo* function = findMathFunction(name);
+                    if (argumentCount != function->arity) {
+                        throw std::runtime_error("Parser error: function '" + std::string(name) + "' expects "
+                            + std::to_string(function->arity) + " argument(s)");
+                    }
+                    output.push_back(makeToken(tokens, source, functionIndex));
+                    operatorStack.pop();
+                }
                 currentState = ExpectingOperator;
                 continue;
             }
 
-            // Конец выражения
-            if (currentToken.type == TokenType::End) {
-                if (currentState == ExpectingOperand) {
-                    throw std::runtime_error("Parser error: incomplete expression");
+            // Запятая завершает очередной аргумент вызова функции
+            if (currentType == TokenType::Comma) {
+                while (!operatorStack.empty() && tokens.types[operatorStack.top()] != TokenType::LeftParen) {
+                    output.push_back(makeToken(tokens, source, operatorStack.top()));
+                    operatorStack.pop();
                 }
+                if (argumentCounts.empty() || argumentCounts.top() == 0) {
+                    throw std::runtime_error("Parser error: ',' outside function call");
+                }
+                argumentCounts.top()++;
+                currentState = ExpectingOperand;
+                continue;
+            }
+
+            // Конец выражения (или место, где лексер встретил ошибку)
+            if (currentType == TokenType::End) {
+                if (lexerErrorHere) throw std::runtime_error(tokens.error);
                 // Выталкиваем все оставшиеся операторы
                 while (!operatorStack.empty()) {
-                    Token stackTop = operatorStack.top();
+                    std::uint32_t stackTop = operatorStack.top();
                     operatorStack.pop();
-                    if (stackTop.type == TokenType::LeftParen) {
+                    if (tokens.types[stackTop] == TokenType::LeftParen) {
                         throw std::runtime_error("Parser error: '(' without matching ')'");
                     }
-                    outputQueue.push_back(stackTop);
+                    output.push_back(makeToken(tokens, source, stackTop));
                 }
-                return outputQueue;
+                return;
             }
 
             throw std::runtime_error("Parser error: operator expected");
         }
     }
-};
\ No newline at end of file
+};
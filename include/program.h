@@ -0,0 +1,160 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <cmath>
+#include "token.h"
+#include "functions.h"
+
+// Байткод стековой машины
+enum class OpCode : std::uint8_t {
+    PushConstant,   // operand - индекс в пуле констант
+    PushVariable,   // operand - номер слота переменной
+    Negate,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Power,          // Показатель вычисляется: pow
+    PowerInt,       // operand - небольшой целый показатель-константа (int32): умножения
+    Call,           // operand - MathFunction, аргументы на вершине стека
+    DivideConstant  // operand - индекс ненулевой константы-делителя: деление без проверки на ноль
+};
+
+struct Instruction {
+    OpCode opCode{ OpCode::PushConstant };
+    std::uint32_t operand{ 0 };
+};
+
+inline int powerIntExponent(const Instruction& instruction) {
+    return static_cast<std::int32_t>(instruction.operand);
+}
+
+// Делитель - степень двойки, и 1/c представимо без денормализации: x / c == x * (1 / c) бит в бит
+inline bool hasExactReciprocal(double divisor) {
+    if (!std::isfinite(divisor) || divisor == 0.0) return false;
+    int exponent = 0;
+    return std::fabs(std::frexp(divisor, &exponent)) == 0.5 && std::isnormal(1.0 / divisor);
+}
+
+// Сколько значений инструкция снимает со стека
+inline std::size_t instructionArity(const Instruction& instruction) {
+    switch (instruction.opCode) {
+    case OpCode::PushConstant:
+    case OpCode::PushVariable:
+        return 0;
+    case OpCode::Negate:
+    case OpCode::PowerInt:
+    case OpCode::DivideConstant:
+        return 1;
+    case OpCode::Call:
+        return mathFunctionInfo(static_cast<MathFunction>(instruction.operand)).arity;
+    default:
+        return 2;
+    }
+}
+
+// Максимальная глубина стека; бросает исключение, если код некорректен
+inline std::size_t computeStackDepth(const std::vector<Instruction>& code) {
+    std::size_t depth = 0, maxDepth = 0;
+    for (const Instruction& instruction : code) {
+        std::size_t arity = instructionArity(instruction);
+        if (depth < arity) throw std::runtime_error("Compiler error: stack underflow");
+        depth = depth - arity + 1;
+        if (depth > maxDepth) maxDepth = depth;
+    }
+    if (depth != 1) throw std::runtime_error("Compiler error: invalid expression");
+    return maxDepth;
+}
+
+// Скомпилированное выражение: разбирается один раз, вычисляется многократно
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::vector<std::string> variables;   // Имена слотов в порядке первого появления
+    std::size_t stackDepth{ 0 };          // Максимальная глубина стека при вычислении
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::size_t findVariable(std::string_view name) const {
+        for (std::size_t slot = 0; slot < variables.size(); ++slot) {
+            if (variables[slot] == name) return slot;
+        }
+        return npos;
+    }
+};
+
+// Перевод RPN в байткод: константы в пул, переменные в слоты, подсчет глубины стека
+class Compiler {
+    static OpCode binaryOpCode(char operatorChar) {
+        switch (operatorChar) {
+        case '+': return OpCode::Add;
+        case '-': return OpCode::Subtract;
+        case '*': return OpCode::Multiply;
+        case '/': return OpCode::Divide;
+        case '^': return OpCode::Power;
+        default: throw std::runtime_error("Compiler error: unknown operator");
+        }
+    }
+
+public:
+    static Program compile(const std::vector<Token>& rpnTokens) {
+        Program program;
+        program.code.reserve(rpnTokens.size());
+        std::size_t depth = 0;
+
+        for (const Token& token : rpnTokens) {
+            if (token.type == TokenType::Number) {
+                program.code.push_back({ OpCode::PushConstant, static_cast<std::uint32_t>(program.constants.size()) });
+                program.constants.push_back(token.numericValue);
+                depth++;
+            }
+            else if (token.type == TokenType::Identifier) {
+                std::size_t slot = program.findVariable(token.content);
+                if (slot == Program::npos) {
+                    slot = program.variables.size();
+                    program.variables.push_back(token.content);
+                }
+                program.code.push_back({ OpCode::PushVariable, static_cast<std::uint32_t>(slot) });
+                depth++;
+            }
+            else if (token.type == TokenType::Function) {
+                const MathFunctionInfo* function = findMathFunction(token.content);
+                if (!function) throw std::runtime_error("Compiler error: unknown function '" + token.content + "'");
+                if (depth < function->arity) throw std::runtime_error("Compiler error: function needs more operands");
+                program.code.push_back({ OpCode::Call, static_cast<std::uint32_t>(function->id) });
+                depth = depth - function->arity + 1;
+            }
+            else if (token.type == TokenType::Operator && token.getOperatorChar() == '~') {
+                if (depth < 1) throw std::runtime_error("Compiler error: unary minus needs 1 operand");
+                program.code.push_back({ OpCode::Negate, 0 });
+            }
+            else if (token.type == TokenType::Operator) {
+                if (depth < 2) throw std::runtime_error("Compiler error: binary operator needs 2 operands");
+                const Instruction& previous = program.code.back();
+                if (token.getOperatorChar() == '^' && previous.opCode == OpCode::PushConstant &&
+                    isSmallIntegerExponent(program.constants[previous.operand])) {
+                    // Показатель - последняя добавленная константа: заменяем ее на PowerInt
+                    int exponent = static_cast<int>(program.constants[previous.operand]);
+                    program.code.pop_back();
+                    program.constants.pop_back();
+                    program.code.push_back({ OpCode::PowerInt, static_cast<std::uint32_t>(static_cast<std::int32_t>(exponent)) });
+                }
+                else {
+                    program.code.push_back({ binaryOpCode(token.getOperatorChar()), 0 });
+                }
+                depth--;
+            }
+            else {
+                throw std::runtime_error("Compiler error: unexpected token in RPN");
+            }
+            if (depth > program.stackDepth) program.stackDepth = depth;
+        }
+
+        if (depth != 1) throw std::runtime_error("Compiler error: invalid expression");
+        return program;
+    }
+};
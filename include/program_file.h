@@ -0,0 +1,349 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <span>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "program.h"
+#include "functions.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TRANSLATOR_HAS_MMAP 1
+#else
+#define TRANSLATOR_HAS_MMAP 0
+#endif
+
+// Двоичный формат библиотеки скомпилированных программ. Все числа little-endian, double - IEEE 754 binary64.
+//
+//   Заголовок (48 байт): "TRPL", u32 версия, u32 число программ, u32 0,
+//                        u64 смещение каталога, u64 смещение строк, u64 размер строк, u64 размер файла
+//   Каталог: на программу 40 байт - u64 смещение кода, u64 смещение констант, u64 смещение таблицы имен,
+//            u32 число инструкций, u32 число констант, u32 число переменных, u32 глубина стека
+//   Код: инструкции по 8 байт - u8 OpCode, 3 нулевых байта, u32 operand (раскладка struct Instruction)
+//   Константы: f64; таблица имен: пары u32 (смещение, длина) в блоке строк
+//
+// Код и константы выровнены на 8 байт, поэтому при загрузке на little-endian машине они читаются прямо из mmap.
+inline constexpr char kProgramFileMagic[4] = { 'T', 'R', 'P', 'L' };
+inline constexpr std::uint32_t kProgramFileVersion = 1;
+
+static_assert(sizeof(Instruction) == 8 && offsetof(Instruction, operand) == 4 && std::is_trivially_copyable_v<Instruction>,
+              "Instruction layout must match the file format");
+static_assert(std::numeric_limits<double>::is_iec559, "double must be IEEE 754 binary64");
+
+// Программа, загруженная из файла: те же поля, что у Program, но без владения памятью
+struct ProgramView {
+    std::span<const Instruction> code;
+    std::span<const double> constants;
+    std::span<const std::uint32_t> nameTable;   // Пары (смещение, длина) в strings
+    std::string_view strings;
+    std::size_t stackDepth{ 0 };
+
+    std::size_t variableCount() const noexcept { return nameTable.size() / 2; }
+    std::string_view variableName(std::size_t slot) const { return strings.substr(nameTable[slot * 2], nameTable[slot * 2 + 1]); }
+
+    // Копия в обычную Program (для регистровой машины, оптимизатора и т.п.)
+    Program toProgram() const {
+        Program program;
+        program.code.assign(code.begin(), code.end());
+        program.constants.assign(constants.begin(), constants.end());
+        for (std::size_t slot = 0; slot < variableCount(); ++slot) program.variables.emplace_back(variableName(slot));
+        program.stackDepth = stackDepth;
+        return program;
+    }
+};
+
+class ProgramLibrary {
+    static constexpr std::size_t kHeaderSize = 48;
+    static constexpr std::size_t kEntrySize = 40;
+
+    // Файл целиком в памяти: mmap, где он есть, иначе обычное чтение
+    class MappedFile {
+        const std::byte* bytes{ nullptr };
+        std::size_t length{ 0 };
+        std::vector<std::byte> buffer;
+        bool mapped{ false };
+
+        void release() noexcept {
+#if TRANSLATOR_HAS_MMAP
+            if (mapped) munmap(const_cast<std::byte*>(bytes), length);
+#endif
+            bytes = nullptr;
+            length = 0;
+            mapped = false;
+            buffer.clear();
+        }
+
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path) {
+#if TRANSLATOR_HAS_MMAP
+            int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0) throw std::runtime_error("ProgramLibrary error: cannot open '" + path + "'");
+            struct stat status;
+            if (fstat(descriptor, &status) != 0) {
+                ::close(descriptor);
+                throw std::runtime_error("ProgramLibrary error: cannot stat '" + path + "'");
+            }
+            length = static_cast<std::size_t>(status.st_size);
+            if (length != 0) {
+                void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (address == MAP_FAILED) {
+                    ::close(descriptor);
+                    throw std::runtime_error("ProgramLibrary error: cannot map '" + path + "'");
+                }
+                bytes = static_cast<const std::byte*>(address);
+                mapped = true;
+            }
+            ::close(descriptor);
+#else
+            std::ifstream input(path, std::ios::binary | std::ios::ate);
+            if (!input) throw std::runtime_error("ProgramLibrary error: cannot open '" + path + "'");
+            buffer.resize(static_cast<std::size_t>(input.tellg()));
+            input.seekg(0);
+            input.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            bytes = buffer.data();
+            length = buffer.size();
+#endif
+        }
+        ~MappedFile() { release(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                release();
+                bytes = other.bytes;
+                length = other.length;
+                buffer = std::move(other.buffer);
+                mapped = other.mapped;
+                other.bytes = nullptr;
+                other.length = 0;
+                other.mapped = false;
+            }
+            return *this;
+        }
+
+        const std::byte* data() const noexcept { return bytes; }
+        std::size_t size() const noexcept { return length; }
+    };
+
+    MappedFile file;
+    std::vector<ProgramView> views;
+
+    template <typename T>
+    static T readLittleEndian(const std::byte* source) {
+        T value;
+        std::memcpy(&value, source, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    static void appendLittleEndian(std::string& buffer, T value) {
+        char raw[sizeof(T)];
+        std::memcpy(raw, &value, sizeof(T));
+        if constexpr (std::endian::native == std::endian::big) {
+            for (std::size_t i = 0; i < sizeof(T) / 2; ++i) std::swap(raw[i], raw[sizeof(T) - 1 - i]);
+        }
+        buffer.append(raw, sizeof(T));
+    }
+
+    static void alignTo(std::string& buffer, std::size_t alignment) {
+        buffer.append((alignment - buffer.size() % alignment) % alignment, '\0');
+    }
+
+    [[noreturn]] static void corrupted(const std::string& reason) {
+        throw std::runtime_error("ProgramLibrary error: corrupted file (" + reason + ")");
+    }
+
+    // Проверка одной программы: операнды в пределах пулов, стек не уходит в минус, глубина совпадает
+    static void validate(const ProgramView& program) {
+        std::size_t depth = 0, maxDepth = 0;
+        for (const Instruction& instruction : program.code) {
+            switch (instruction.opCode) {
+            case OpCode::PushConstant:
+                if (instruction.operand >= program.constants.size()) corrupted("constant index out of range");
+                break;
+            case OpCode::PushVariable:
+                if (instruction.operand >= program.variableCount()) corrupted("variable slot out of range");
+                break;
+            case OpCode::DivideConstant:
+                // Деление выполняется без проверки на ноль, поэтому делитель проверяется здесь
+                if (instruction.operand >= program.constants.size() || program.constants[instruction.operand] == 0.0) {
+                    corrupted("invalid constant divisor");
+                }
+                break;
+            case OpCode::PowerInt:
+                if (!isSmallIntegerExponent(powerIntExponent(instruction))) corrupted("exponent out of range");
+                break;
+            case OpCode::Call:
+                if (instruction.operand >= kMathFunctions.size()) corrupted("unknown function");
+                break;
+            case OpCode::Negate:
+            case OpCode::Add:
+            case OpCode::Subtract:
+            case OpCode::Multiply:
+            case OpCode::Divide:
+            case OpCode::Power:
+                break;
+            default:
+                corrupted("unknown opcode");
+            }
+            std::size_t arity = instructionArity(instruction);
+            if (depth < arity) corrupted("stack underflow");
+            depth = depth - arity + 1;
+            if (depth > maxDepth) maxDepth = depth;
+        }
+        if (depth != 1 || maxDepth != program.stackDepth) corrupted("invalid stack depth");
+    }
+
+public:
+    // Запись во временный файл и переименование: читатели никогда не видят недописанную библиотеку
+    static void save(const std::string& path, const std::vector<Program>& programs) {
+        std::string strings;
+        for (const Program& program : programs) {
+            for (const std::string& name : program.variables) strings += name;
+        }
+
+        std::string buffer;
+        buffer.append(kProgramFileMagic, sizeof(kProgramFileMagic));
+        appendLittleEndian<std::uint32_t>(buffer, kProgramFileVersion);
+        appendLittleEndian<std::uint32_t>(buffer, static_cast<std::uint32_t>(programs.size()));
+        appendLittleEndian<std::uint32_t>(buffer, 0);
+        appendLittleEndian<std::uint64_t>(buffer, kHeaderSize);
+        const std::size_t stringsOffsetField = buffer.size();
+        appendLittleEndian<std::uint64_t>(buffer, 0);
+        appendLittleEndian<std::uint64_t>(buffer, strings.size());
+        const std::size_t fileSizeField = buffer.size();
+        appendLittleEndian<std::uint64_t>(buffer, 0);
+
+        // Каталог заполняется после того, как станут известны смещения секций
+        buffer.append(programs.size() * kEntrySize, '\0');
+        std::string directory;
+        std::size_t stringOffset = 0;
+        for (const Program& program : programs) {
+            alignTo(buffer, 8);
+            const std::uint64_t codeOffset = buffer.size();
+            for (const Instruction& instruction : program.code) {
+                appendLittleEndian<std::uint8_t>(buffer, static_cast<std::uint8_t>(instruction.opCode));
+                buffer.append(3, '\0');
+                appendLittleEndian<std::uint32_t>(buffer, instruction.operand);
+            }
+            const std::uint64_t constantsOffset = buffer.size();
+            for (double constant : program.constants) appendLittleEndian<std::uint64_t>(buffer, std::bit_cast<std::uint64_t>(constant));
+            const std::uint64_t namesOffset = buffer.size();
+            for (const std::string& name : program.variables) {
+                appendLittleEndian<std::uint32_t>(buffer, static_cast<std::uint32_t>(stringOffset));
+                appendLittleEndian<std::uint32_t>(buffer, static_cast<std::uint32_t>(name.size()));
+                stringOffset += name.size();
+            }
+
+            appendLittleEndian<std::uint64_t>(directory, codeOffset);
+            appendLittleEndian<std::uint64_t>(directory, constantsOffset);
+            appendLittleEndian<std::uint64_t>(directory, namesOffset);
+            appendLittleEndian<std::uint32_t>(directory, static_cast<std::uint32_t>(program.code.size()));
+            appendLittleEndian<std::uint32_t>(directory, static_cast<std::uint32_t>(program.constants.size()));
+            appendLittleEndian<std::uint32_t>(directory, static_cast<std::uint32_t>(program.variables.size()));
+            appendLittleEndian<std::uint32_t>(directory, static_cast<std::uint32_t>(program.stackDepth));
+        }
+        buffer.replace(kHeaderSize, directory.size(), directory);
+
+        std::string field;
+        appendLittleEndian<std::uint64_t>(field, buffer.size());
+        buffer.replace(stringsOffsetField, field.size(), field);
+        buffer += strings;
+        field.clear();
+        appendLittleEndian<std::uint64_t>(field, buffer.size());
+        buffer.replace(fileSizeField, field.size(), field);
+
+        const std::string temporaryPath = path + ".tmp";
+        {
+            std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!output) throw std::runtime_error("ProgramLibrary error: cannot write '" + temporaryPath + "'");
+            output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!output.flush()) throw std::runtime_error("ProgramLibrary error: cannot write '" + temporaryPath + "'");
+        }
+        if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            std::remove(temporaryPath.c_str());
+            throw std::runtime_error("ProgramLibrary error: cannot replace '" + path + "'");
+        }
+    }
+
+    // Отображение файла в память и проверка всех программ; код и константы не копируются
+    static ProgramLibrary load(const std::string& path) {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw std::runtime_error("ProgramLibrary error: big-endian hosts are not supported");
+        }
+
+        ProgramLibrary library;
+        library.file = MappedFile(path);
+        const std::byte* bytes = library.file.data();
+        const std::size_t size = library.file.size();
+
+        if (size < kHeaderSize) corrupted("truncated header");
+        if (std::memcmp(bytes, kProgramFileMagic, sizeof(kProgramFileMagic)) != 0) corrupted("bad magic");
+        if (readLittleEndian<std::uint32_t>(bytes + 4) != kProgramFileVersion) {
+            throw std::runtime_error("ProgramLibrary error: unsupported format version");
+        }
+        const std::uint32_t count = readLittleEndian<std::uint32_t>(bytes + 8);
+        const std::uint64_t directoryOffset = readLittleEndian<std::uint64_t>(bytes + 16);
+        const std::uint64_t stringsOffset = readLittleEndian<std::uint64_t>(bytes + 24);
+        const std::uint64_t stringsSize = readLittleEndian<std::uint64_t>(bytes + 32);
+        if (readLittleEndian<std::uint64_t>(bytes + 40) != size) corrupted("size mismatch");
+        if (directoryOffset > size || count > (size - directoryOffset) / kEntrySize) corrupted("directory out of range");
+        if (stringsOffset > size || stringsSize > size - stringsOffset) corrupted("strings out of range");
+        const std::string_view strings(reinterpret_cast<const char*>(bytes + stringsOffset), stringsSize);
+
+        // Секция [offset, offset + count * width) должна лежать в файле и быть выровнена
+        auto section = [&](std::uint64_t offset, std::uint64_t elements, std::size_t width, std::size_t alignment) {
+            if (offset > size || elements > (size - offset) / width || offset % alignment != 0) corrupted("section out of range");
+            return bytes + offset;
+        };
+
+        library.views.reserve(count);
+        for (std::uint32_t index = 0; index < count; ++index) {
+            const std::byte* entry = bytes + directoryOffset + std::size_t{ index } * kEntrySize;
+            const std::uint32_t codeCount = readLittleEndian<std::uint32_t>(entry + 24);
+            const std::uint32_t constantCount = readLittleEndian<std::uint32_t>(entry + 28);
+            const std::uint32_t variableCount = readLittleEndian<std::uint32_t>(entry + 32);
+
+            ProgramView view;
+            view.code = { reinterpret_cast<const Instruction*>(section(readLittleEndian<std::uint64_t>(entry), codeCount, 8, 8)), codeCount };
+            view.constants = { reinterpret_cast<const double*>(section(readLittleEndian<std::uint64_t>(entry + 8), constantCount, 8, 8)),
+                               constantCount };
+            view.nameTable = { reinterpret_cast<const std::uint32_t*>(section(readLittleEndian<std::uint64_t>(entry + 16), variableCount, 8, 4)),
+                               std::size_t{ variableCount } * 2 };
+            view.strings = strings;
+            view.stackDepth = readLittleEndian<std::uint32_t>(entry + 36);
+
+            for (std::size_t slot = 0; slot < variableCount; ++slot) {
+                if (view.nameTable[slot * 2] > stringsSize || view.nameTable[slot * 2 + 1] > stringsSize - view.nameTable[slot * 2]) {
+                    corrupted("variable name out of range");
+                }
+            }
+            validate(view);
+            library.views.push_back(view);
+        }
+        return library;
+    }
+
+    std::size_t size() const noexcept { return views.size(); }
+    const ProgramView& operator[](std::size_t index) const { return views[index]; }
+    const ProgramView& at(std::size_t index) const {
+        if (index >= views.size()) throw std::out_of_range("ProgramLibrary: index out of range");
+        return views[index];
+    }
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <string>
+#include <stdexcept>
+#include <cctype>
+#include <cstdlib>
+#include "lexer.h"
+#include "token.h"
+
+// Прежний лексер на цепочке сравнений. Оставлен как эталон для дифференциальных тестов
+// и замеров табличного Lexer; в вычислениях не используется
+class ReferenceLexer {
+    std::string inputText;
+    size_t currentPosition{ 0 };
+    Token lastToken{ Token::createEnd() };  // Для определения унарного минуса
+
+    void advancePastWhitespace() {
+        while (currentPosition < inputText.size() && Lexer::isWhitespace(inputText[currentPosition])) {
+            currentPosition++;
+        }
+    }
+
+    // Унарный минус возможен после начала выражения, оператора, открывающей скобки или запятой
+    bool canBeUnaryMinus() const {
+        if (lastToken.type == TokenType::End) return true;
+        if (lastToken.type == TokenType::Operator) return true;
+        if (lastToken.type == TokenType::LeftParen) return true;
+        if (lastToken.type == TokenType::Comma) return true;
+        return false;
+    }
+
+    // Следующий значимый символ - открывающая скобка (имя функции, а не переменной)
+    bool nextIsLeftParen() const {
+        size_t lookahead = currentPosition;
+        while (lookahead < inputText.size() && Lexer::isWhitespace(inputText[lookahead])) lookahead++;
+        return lookahead < inputText.size() && inputText[lookahead] == '(';
+    }
+
+public:
+    explicit ReferenceLexer(std::string input = {}) : inputText(std::move(input)) {}
+
+    // Копирование в уже выделенный буфер: при повторных вызовах память не выделяется
+    void setInput(const std::string& input) {
+        inputText.assign(input);
+        currentPosition = 0;
+        lastToken = Token::createEnd();
+    }
+
+    void setInput(std::string&& input) {
+        inputText = std::move(input);
+        currentPosition = 0;
+        lastToken = Token::createEnd();
+    }
+
+    Token getNextToken() {
+        // Пропускаем пробелы
+        advancePastWhitespace();
+        if (currentPosition >= inputText.size()) {
+            lastToken = Token::createEnd();
+            return Token::createEnd();
+        }
+
+        char currentChar = inputText[currentPosition];
+
+        // Обрабатываем скобки
+        if (currentChar == '(') {
+            currentPosition++;
+            lastToken = Token::createLeftParen();
+            return lastToken;
+        }
+        if (currentChar == ')') {
+            currentPosition++;
+            lastToken = Token::createRightParen();
+            return lastToken;
+        }
+        if (currentChar == ',') {
+            currentPosition++;
+            lastToken = Token::createComma();
+            return lastToken;
+        }
+
+        // Обрабатываем операторы
+        if (Lexer::isValidOperator(currentChar)) {
+            currentPosition++;
+            // Определяем унарный или бинарный минус
+            if (currentChar == '-' && canBeUnaryMinus()) {
+                lastToken = Token::createOperator('~'); 
+                return lastToken;
+            }
+            lastToken = Token::createOperator(currentChar);
+            return lastToken;
+        }
+        // Обрабатываем числа
+        if (std::isdigit(static_cast<unsigned char>(currentChar)) || currentChar == '.') {
+            const char* startPtr = inputText.c_str() + currentPosition;
+            char* endPtr = nullptr;
+
+            // Преобразуем строку в число
+            double numValue = std::strtod(startPtr, &endPtr);
+            if (endPtr == startPtr) {
+                throw std::runtime_error("Lexer error: invalid number");
+            }
+
+            // Сохраняем исходное представление числа
+            size_t charsRead = static_cast<size_t>(endPtr - startPtr);
+            std::string originalText = inputText.substr(currentPosition, charsRead);
+            currentPosition += charsRead;
+
+            lastToken = Token::createNumber(numValue, originalText);
+            return lastToken;
+        }
+        // Обрабатываем имена переменных и функций
+        if (Lexer::isIdentifierStart(currentChar)) {
+            size_t nameStart = currentPosition;
+            while (currentPosition < inputText.size() && Lexer::isIdentifierChar(inputText[currentPosition])) {
+                currentPosition++;
+            }
+            std::string name = inputText.substr(nameStart, currentPosition - nameStart);
+            lastToken = nextIsLeftParen() ? Token::createFunction(std::move(name)) : Token::createIdentifier(std::move(name));
+            return lastToken;
+        }
+
+        throw std::runtime_error(std::string("Lexer error: unexpected character '") + currentChar + "'");
+    }
+};
@@ -0,0 +1,148 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include "program.h"
+#include "expression_tree.h"
+#include "functions.h"
+
+// Регистровая машина: трехадресные инструкции над файлом регистров, размер которого известен после компиляции.
+// Регистры [0, C) - константы, [C, C + V) - переменные, дальше - временные значения.
+// Листья дерева не порождают инструкций: операнды ссылаются на регистры констант и переменных напрямую.
+struct RegisterInstruction {
+    OpCode opCode{ OpCode::Add };
+    std::uint32_t operand{ 0 };   // PowerInt - показатель, Call - MathFunction
+    std::uint32_t target{ 0 };
+    std::uint32_t left{ 0 };
+    std::uint32_t right{ 0 };
+};
+
+struct RegisterProgram {
+    std::vector<RegisterInstruction> code;
+    std::vector<double> constants;
+    std::vector<std::string> variables;
+    std::size_t registerCount{ 0 };
+    std::uint32_t resultRegister{ 0 };
+
+    std::size_t variableBase() const noexcept { return constants.size(); }
+    std::size_t temporaryBase() const noexcept { return constants.size() + variables.size(); }
+};
+
+// Распределение регистров по дереву выражения: узлы обходятся в порядке Сетхи-Ульмана,
+// временный регистр освобождается, как только значение использовано, и сразу переиспользуется
+class RegisterCompiler {
+public:
+    static RegisterProgram compile(const Program& program) {
+        RegisterProgram compiled;
+        compiled.constants = program.constants;
+        compiled.variables = program.variables;
+        const std::uint32_t variableBase = static_cast<std::uint32_t>(compiled.variableBase());
+        const std::uint32_t temporaryBase = static_cast<std::uint32_t>(compiled.temporaryBase());
+
+        const std::vector<Instruction> ordered = ExpressionTree::build(program).emit(true);
+        compiled.code.reserve(ordered.size());
+
+        std::vector<std::uint32_t> operandRegisters;
+        operandRegisters.reserve(program.stackDepth);
+        std::vector<std::uint32_t> freeTemporaries;   // Свободные временные регистры, наименьший - последний
+        std::uint32_t temporaryCount = 0;
+
+        auto release = [&](std::uint32_t reg) {
+            if (reg < temporaryBase) return;
+            freeTemporaries.insert(std::upper_bound(freeTemporaries.begin(), freeTemporaries.end(), reg,
+                                                    [](std::uint32_t value, std::uint32_t element) { return value > element; }),
+                                   reg);
+        };
+        auto allocate = [&]() {
+            if (freeTemporaries.empty()) return temporaryBase + temporaryCount++;
+            std::uint32_t reg = freeTemporaries.back();
+            freeTemporaries.pop_back();
+            return reg;
+        };
+
+        for (const Instruction& instruction : ordered) {
+            if (instruction.opCode == OpCode::PushConstant) {
+                operandRegisters.push_back(instruction.operand);
+                continue;
+            }
+            if (instruction.opCode == OpCode::PushVariable) {
+                operandRegisters.push_back(variableBase + instruction.operand);
+                continue;
+            }
+
+            RegisterInstruction registerInstruction;
+            registerInstruction.opCode = instruction.opCode;
+            registerInstruction.operand = instruction.operand;
+            if (instructionArity(instruction) == 2) {
+                registerInstruction.right = operandRegisters.back();
+                operandRegisters.pop_back();
+            }
+            else if (instruction.opCode == OpCode::DivideConstant) {
+                registerInstruction.right = instruction.operand;
+            }
+            registerInstruction.left = operandRegisters.back();
+            operandRegisters.pop_back();
+
+            // Операнды освобождаются до выделения результата: target может совпасть с left
+            release(registerInstruction.left);
+            if (instructionArity(instruction) == 2) release(registerInstruction.right);
+            registerInstruction.target = allocate();
+            operandRegisters.push_back(registerInstruction.target);
+            compiled.code.push_back(registerInstruction);
+        }
+
+        if (operandRegisters.size() != 1) throw std::runtime_error("Compiler error: invalid expression");
+        compiled.resultRegister = operandRegisters.back();
+        compiled.registerCount = temporaryBase + temporaryCount;
+        return compiled;
+    }
+};
+
+// Вычисление регистровой программы; файл регистров переиспользуется между вызовами
+class RegisterVM {
+    std::vector<double> registers;
+
+public:
+    double evaluate(const RegisterProgram& program, const double* variables) {
+        registers.resize(program.registerCount);
+        double* file = registers.data();
+        std::copy(program.constants.begin(), program.constants.end(), file);
+        std::copy(variables, variables + program.variables.size(), file + program.variableBase());
+
+        for (const RegisterInstruction& instruction : program.code) {
+            const double leftOperand = file[instruction.left];
+            double& target = file[instruction.target];
+            switch (instruction.opCode) {
+            case OpCode::Negate: target = -leftOperand; break;
+            case OpCode::Add: target = leftOperand + file[instruction.right]; break;
+            case OpCode::Subtract: target = leftOperand - file[instruction.right]; break;
+            case OpCode::Multiply: target = leftOperand * file[instruction.right]; break;
+            case OpCode::Divide: {
+                const double rightOperand = file[instruction.right];
+                if (rightOperand == 0.0) throw std::runtime_error("Eval error: division by zero");
+                target = leftOperand / rightOperand;
+                break;
+            }
+            case OpCode::DivideConstant: target = leftOperand / file[instruction.right]; break;
+            case OpCode::Power:
+                target = applyMathFunction(MathFunction::Pow, leftOperand, file[instruction.right]);
+                break;
+            case OpCode::PowerInt:
+                target = integerPower(leftOperand, static_cast<std::int32_t>(instruction.operand));
+                break;
+            case OpCode::Call: {
+                MathFunction function = static_cast<MathFunction>(instruction.operand);
+                target = applyMathFunction(function, leftOperand,
+                                           mathFunctionInfo(function).arity == 2 ? file[instruction.right] : 0.0);
+                break;
+            }
+            default:
+                throw std::runtime_error("Eval error: unknown instruction");
+            }
+        }
+        return file[program.resultRegister];
+    }
+};
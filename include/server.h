@@ -0,0 +1,403 @@
+#pragma once
+#if defined(__linux__)
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "translator.h"
+#include "number_format.h"
+#include "thread_pool.h"
+
+struct ServerOptions {
+    std::string unixPath;            // Путь Unix-сокета; пустой - не слушать
+    std::uint16_t tcpPort{ 0 };      // Порт на 127.0.0.1; 0 - не слушать
+    std::size_t workerCount{ std::max<std::size_t>(1, std::thread::hardware_concurrency()) };
+    std::size_t maxBatch{ 1024 };    // Строк в одной пачке для потока-вычислителя
+    EvaluationLimits limits{ EvaluationLimits::serverDefaults() };  // На каждую строку запроса
+};
+
+// Сервер вычисления выражений. Запросы - строки, разделенные '\n', ответ на каждую - строка
+// с результатом или "Error: ...", в том же порядке. Результат - кратчайшая запись, которая читается
+// обратно в тот же double. Клиент может отправлять запросы, не дожидаясь ответов.
+// Один поток ведет цикл epoll с неблокирующими сокетами; накопленные строки соединения уходят пачкой
+// в пул, где у каждого потока свой Translator. У соединения в работе не больше одной пачки,
+// поэтому ответы не переупорядочиваются, а под нагрузкой пачки сами становятся крупнее.
+class EvaluationServer {
+    static constexpr std::size_t kReadChunk = 64 * 1024;
+    // Нижняя граница буфера непрочитанных строк: при коротком лимите строки клиент все равно может слать запросы пачкой
+    static constexpr std::size_t kMinPendingInput = 4 * 1024 * 1024;
+
+    struct Connection {
+        int descriptor{ -1 };
+        std::string input;
+        std::string output;
+        std::size_t outputSent{ 0 };
+        bool batchInFlight{ false };
+        bool peerClosed{ false };
+        bool skippingLine{ false };   // Байты до следующего '\n' - хвост отвергнутой длинной строки
+        std::uint32_t events{ 0 };
+    };
+
+    struct CompletedBatch {
+        std::uint64_t connectionId;
+        std::string responses;
+    };
+
+    ServerOptions options;
+    // Пока пачка считается, непрочитанные данные копятся до этого предела, затем чтение приостанавливается.
+    // Предел больше самой длинной допустимой строки (с "\r\n"), поэтому такая строка всегда дочитывается
+    std::size_t maxPendingInput{ kMinPendingInput };
+    int epollDescriptor{ -1 };
+    int wakeDescriptor{ -1 };      // eventfd: готовые пачки и stop()
+    std::vector<int> listeners;
+    std::unordered_map<std::uint64_t, Connection> connections;
+    std::uint64_t nextConnectionId{ 0 };
+    // Идентификаторы ниже этого - слушающие сокеты и eventfd
+    static constexpr std::uint64_t kFirstConnectionId = 16;
+    static constexpr std::uint64_t kWakeId = 0;
+
+    std::unique_ptr<ThreadPool> workers;
+    std::mutex completedMutex;
+    std::vector<CompletedBatch> completed;
+    std::atomic<bool> stopping{ false };
+
+    [[noreturn]] static void systemError(const std::string& what) {
+        throw std::runtime_error("Server error: " + what + ": " + std::strerror(errno));
+    }
+
+    void watch(int descriptor, std::uint64_t id, std::uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        if (epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, descriptor, &event) != 0) systemError("epoll_ctl");
+    }
+
+    void updateEvents(std::uint64_t id, Connection& connection, std::uint32_t events) {
+        if (connection.events == events) return;
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, connection.descriptor, &event);
+        connection.events = events;
+    }
+
+    void listenUnix(const std::string& path) {
+        int descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (descriptor < 0) systemError("socket");
+        listeners.push_back(descriptor);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Server error: socket path too long");
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        ::unlink(path.c_str());
+        if (bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) systemError("bind '" + path + "'");
+        if (listen(descriptor, SOMAXCONN) != 0) systemError("listen");
+        watch(descriptor, listeners.size(), EPOLLIN);
+    }
+
+    void listenTcp(std::uint16_t port) {
+        int descriptor = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (descriptor < 0) systemError("socket");
+        listeners.push_back(descriptor);
+        int enable = 1;
+        setsockopt(descriptor, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) systemError("bind tcp");
+        if (listen(descriptor, SOMAXCONN) != 0) systemError("listen");
+        watch(descriptor, listeners.size(), EPOLLIN);
+    }
+
+    void acceptAll(int listener) {
+        for (;;) {
+            int descriptor = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (descriptor < 0) return;   // EAGAIN или временная ошибка: остальные подождут следующего события
+            int enable = 1;
+            setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));   // Для Unix-сокета не действует
+            std::uint64_t id = nextConnectionId++;
+            Connection& connection = connections[id];
+            connection.descriptor = descriptor;
+            connection.events = EPOLLIN | EPOLLRDHUP;
+            watch(descriptor, id, connection.events);
+        }
+    }
+
+    void closeConnection(std::uint64_t id) {
+        auto found = connections.find(id);
+        if (found == connections.end()) return;
+        ::close(found->second.descriptor);   // close снимает дескриптор с epoll
+        connections.erase(found);
+    }
+
+    static std::string evaluateBatch(const std::string& lines, bool finalLineComplete, const EvaluationLimits& limits) {
+        static thread_local Translator translator;
+        translator.setLimits(limits);
+        std::string responses;
+        responses.reserve(lines.size());
+        char number[kMaxFormattedNumber];
+        std::size_t begin = 0;
+        while (begin < lines.size()) {
+            std::size_t end = lines.find('\n', begin);
+            if (end == std::string::npos) {
+                if (finalLineComplete) end = lines.size();
+                else break;
+            }
+            std::string_view line(lines.data() + begin, end - begin);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            try {
+                // Строка не копируется, если она все равно будет отвергнута
+                if (line.size() > limits.maxInputBytes) throw LimitExceeded(LimitKind::InputBytes, limits.maxInputBytes);
+                double result = translator.calculate(std::string(line));
+                responses.append(number, formatNumber(result, number));
+            }
+            catch (const std::exception& e) {
+                responses += "Error: ";
+                responses += e.what();
+            }
+            responses += '\n';
+            begin = end + 1;
+        }
+        return responses;
+    }
+
+    // Хвост отвергнутой строки выбрасывается до '\n' включительно
+    static void skipRejectedLine(Connection& connection) {
+        const std::size_t newline = connection.input.find('\n');
+        if (newline == std::string::npos) {
+            connection.input.clear();
+            return;
+        }
+        connection.input.erase(0, newline + 1);
+        connection.skippingLine = false;
+    }
+
+    // Все целые строки соединения (не больше maxBatch) уходят пачкой в пул
+    void dispatch(std::uint64_t id, Connection& connection) {
+        if (connection.batchInFlight) return;
+        if (connection.skippingLine) skipRejectedLine(connection);
+        if (connection.input.empty()) return;
+        std::size_t end = 0, lineCount = 0;
+        while (lineCount < options.maxBatch) {
+            std::size_t newline = connection.input.find('\n', end);
+            if (newline == std::string::npos) break;
+            end = newline + 1;
+            lineCount++;
+        }
+        // Недописанная последняя строка после закрытия записи клиентом - тоже запрос
+        const bool takeTail = lineCount < options.maxBatch && connection.peerClosed && end < connection.input.size();
+        if (takeTail) end = connection.input.size();
+        if (end == 0) {
+            // Недописанная строка уже длиннее лимита (с запасом на '\r'): ответ известен без '\n',
+            // иначе буфер заполнится и соединение перестанет читать, не получив ни одной целой строки
+            if (connection.input.size() > options.limits.maxInputBytes &&
+                connection.input.size() - options.limits.maxInputBytes > 1) {
+                connection.output += "Error: ";
+                connection.output += LimitExceeded(LimitKind::InputBytes, options.limits.maxInputBytes).what();
+                connection.output += '\n';
+                connection.skippingLine = true;
+                skipRejectedLine(connection);
+            }
+            return;
+        }
+
+        std::string lines = connection.input.substr(0, end);
+        connection.input.erase(0, end);
+        connection.batchInFlight = true;
+        workers->submit([this, id, lines = std::move(lines), takeTail] {
+            CompletedBatch batch{ id, evaluateBatch(lines, takeTail, options.limits) };
+            {
+                std::lock_guard<std::mutex> lock(completedMutex);
+                completed.push_back(std::move(batch));
+            }
+            wake();
+        });
+    }
+
+    void wake() {
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = ::write(wakeDescriptor, &one, sizeof(one));
+    }
+
+    // Пытаемся отправить накопленный вывод; остаток ждет EPOLLOUT
+    bool flush(Connection& connection) {
+        while (connection.outputSent < connection.output.size()) {
+            ssize_t sent = send(connection.descriptor, connection.output.data() + connection.outputSent,
+                                connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                if (errno == EINTR) continue;
+                return false;
+            }
+            connection.outputSent += static_cast<std::size_t>(sent);
+        }
+        if (connection.outputSent == connection.output.size()) {
+            connection.output.clear();
+            connection.outputSent = 0;
+        }
+        return true;
+    }
+
+    // Пересчет подписки на события и закрытие завершенного соединения
+    void settle(std::uint64_t id, Connection& connection) {
+        if (!flush(connection)) {
+            closeConnection(id);
+            return;
+        }
+        const std::size_t outputBefore = connection.output.size();
+        dispatch(id, connection);
+        // Ответ об отвергнутой строке отправляется сразу
+        if (connection.output.size() != outputBefore && !flush(connection)) {
+            closeConnection(id);
+            return;
+        }
+        if (connection.peerClosed && !connection.batchInFlight && connection.output.empty()) {
+            closeConnection(id);
+            return;
+        }
+        std::uint32_t events = 0;
+        if (!connection.peerClosed && connection.input.size() < maxPendingInput) events |= EPOLLIN | EPOLLRDHUP;
+        if (!connection.output.empty()) events |= EPOLLOUT;
+        // Без чтения, записи и пачки в работе соединение больше не сдвинется
+        if (events == 0 && !connection.batchInFlight) {
+            closeConnection(id);
+            return;
+        }
+        updateEvents(id, connection, events);
+    }
+
+    void readAll(std::uint64_t id, Connection& connection) {
+        char buffer[kReadChunk];
+        while (connection.input.size() < maxPendingInput) {
+            ssize_t received = ::read(connection.descriptor, buffer, sizeof(buffer));
+            if (received > 0) {
+                connection.input.append(buffer, static_cast<std::size_t>(received));
+                continue;
+            }
+            if (received == 0) {
+                connection.peerClosed = true;
+                break;
+            }
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                closeConnection(id);
+                return;
+            }
+            break;
+        }
+        settle(id, connection);
+    }
+
+    void drainCompleted() {
+        std::uint64_t counter = 0;
+        [[maybe_unused]] ssize_t received = ::read(wakeDescriptor, &counter, sizeof(counter));
+        std::vector<CompletedBatch> batches;
+        {
+            std::lock_guard<std::mutex> lock(completedMutex);
+            batches.swap(completed);
+        }
+        for (CompletedBatch& batch : batches) {
+            auto found = connections.find(batch.connectionId);
+            if (found == connections.end()) continue;   // Соединение закрылось, пока пачка считалась
+            Connection& connection = found->second;
+            connection.batchInFlight = false;
+            connection.output += batch.responses;
+            settle(batch.connectionId, connection);
+        }
+    }
+
+public:
+    explicit EvaluationServer(ServerOptions serverOptions)
+        : options(std::move(serverOptions)), nextConnectionId(kFirstConnectionId),
+          workers(std::make_unique<ThreadPool>(options.workerCount)) {
+        if (options.unixPath.empty() && options.tcpPort == 0) throw std::runtime_error("Server error: no socket to listen on");
+        if (options.maxBatch == 0) options.maxBatch = 1;
+        // Без лимита на строку буфер тоже не ограничен
+        const std::size_t maxInputBytes = options.limits.maxInputBytes;
+        maxPendingInput = maxInputBytes > EvaluationLimits::kUnlimited - 2 ? EvaluationLimits::kUnlimited
+                                                                              : std::max(kMinPendingInput, maxInputBytes + 2);
+        epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+        if (epollDescriptor < 0) systemError("epoll_create1");
+        wakeDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeDescriptor < 0) systemError("eventfd");
+        watch(wakeDescriptor, kWakeId, EPOLLIN);
+        if (!options.unixPath.empty()) listenUnix(options.unixPath);
+        if (options.tcpPort != 0) listenTcp(options.tcpPort);
+    }
+
+    EvaluationServer(const EvaluationServer&) = delete;
+    EvaluationServer& operator=(const EvaluationServer&) = delete;
+
+    ~EvaluationServer() {
+        // Сначала дожидаемся потоков: их задачи пишут в completed и в eventfd
+        workers.reset();
+        for (auto& [id, connection] : connections) ::close(connection.descriptor);
+        for (int listener : listeners) ::close(listener);
+        if (!options.unixPath.empty()) ::unlink(options.unixPath.c_str());
+        if (wakeDescriptor >= 0) ::close(wakeDescriptor);
+        if (epollDescriptor >= 0) ::close(epollDescriptor);
+    }
+
+    // Цикл событий; возвращается после stop()
+    void run() {
+        std::vector<epoll_event> events(256);
+        while (!stopping.load(std::memory_order_acquire)) {
+            int ready = epoll_wait(epollDescriptor, events.data(), static_cast<int>(events.size()), -1);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                systemError("epoll_wait");
+            }
+            for (int i = 0; i < ready; ++i) {
+                const std::uint64_t id = events[i].data.u64;
+                if (id == kWakeId) {
+                    drainCompleted();
+                    continue;
+                }
+                if (id < kFirstConnectionId) {
+                    acceptAll(listeners[id - 1]);
+                    continue;
+                }
+                auto found = connections.find(id);
+                if (found == connections.end()) continue;
+                Connection& connection = found->second;
+                // EPOLLHUP - закрыты оба направления: ответы уже не доставить, а событие приходит
+                // без подписки и повторялось бы, пока соединение не читает
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(id);
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP)) readAll(id, connection);
+                else if (events[i].events & EPOLLOUT) settle(id, connection);
+            }
+        }
+    }
+
+    // Безопасно вызывать из другого потока и из обработчика сигнала
+    void stop() noexcept {
+        stopping.store(true, std::memory_order_release);
+        wake();
+    }
+
+    std::size_t connectionCount() const noexcept { return connections.size(); }
+};
+#endif
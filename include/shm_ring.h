@@ -0,0 +1,471 @@
+#pragma once
+#if defined(__linux__)
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <chrono>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "translator.h"
+
+// Обмен с вычислителем через разделяемую память. У каждого клиента свой слот с двумя кольцами
+// "один писатель - один читатель": запросы клиент -> сервер и ответы сервер -> клиент.
+// Кольцо без блокировок; системный вызов (futex) нужен, только если вторая сторона заснула,
+// а до этого ожидающая сторона некоторое время крутится в цикле.
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+              "shared-memory rings need lock-free atomics");
+
+inline constexpr std::size_t kCacheLine = 64;
+
+// Подсказка процессору внутри цикла ожидания
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// На одном ядре крутиться бессмысленно: вторая сторона не может работать, пока мы ждем
+inline std::size_t defaultSpinCount() {
+    return std::thread::hardware_concurrency() > 1 ? 20000 : 0;
+}
+
+inline void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected, const timespec* timeout = nullptr) {
+    // Без FUTEX_PRIVATE_FLAG: слово лежит в памяти, отображенной в разные процессы
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+inline void futexWakeAll(std::atomic<std::uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Процесс жив (или принадлежит другому пользователю); pid сравниваются в одном пространстве имен pid.
+// Незавершенный зомби считается живым, пока родитель его не дождется
+inline bool processAlive(std::int32_t pid) {
+    return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+// Кольцо записей переменной длины. Запись - u32 длина и данные, выровненные на 8 байт;
+// если запись не помещается до конца буфера, пишется маркер перехода на начало.
+// head и tail - монотонные счетчики байт; Capacity - степень двойки.
+template <std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 64 && (Capacity & (Capacity - 1)) == 0, "ring capacity must be a power of two");
+    static constexpr std::uint32_t kWrapMarker = 0xFFFFFFFFu;
+
+    alignas(kCacheLine) std::atomic<std::uint64_t> head{ 0 };           // Пишет только производитель
+    alignas(kCacheLine) std::atomic<std::uint64_t> tail{ 0 };           // Пишет только потребитель
+    alignas(kCacheLine) std::atomic<std::uint32_t> readerSleeping{ 0 };
+    std::atomic<std::uint32_t> writerSleeping{ 0 };
+    alignas(kCacheLine) unsigned char data[Capacity];
+
+    friend struct SpscRingCorruptor;   // Тесты портят записи так, как это мог бы сделать чужой процесс
+
+    static constexpr std::size_t recordSize(std::size_t length) { return (sizeof(std::uint32_t) + length + 7) & ~std::size_t{ 7 }; }
+
+    // Ожидание условия: сначала цикл, потом futex. Флаг сна выставляется до повторной проверки,
+    // а другая сторона проверяет его после публикации (seq_cst с обеих сторон), поэтому пробуждение не теряется.
+    // peerPid != 0: сон ограничен kPeerCheckInterval, и ожидание прекращается, если процесс peerPid завершился
+    template <typename Ready>
+    static bool waitFor(std::atomic<std::uint32_t>& sleeping, std::size_t spinCount, const std::atomic<bool>* cancel,
+                        std::int32_t peerPid, Ready ready) {
+        static constexpr timespec kPeerCheckInterval{ 0, 100 * 1000 * 1000 };
+        for (std::size_t spin = 0; spin < spinCount; ++spin) {
+            if (ready()) return true;
+            if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+            cpuRelax();
+        }
+        for (;;) {
+            if (ready()) return true;
+            if (cancel && cancel->load(std::memory_order_acquire)) return false;
+            sleeping.store(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready() || (cancel && cancel->load(std::memory_order_seq_cst))) {
+                sleeping.store(0, std::memory_order_relaxed);
+                continue;
+            }
+            futexWait(sleeping, 1, peerPid != 0 ? &kPeerCheckInterval : nullptr);
+            sleeping.store(0, std::memory_order_relaxed);
+            if (peerPid != 0 && !ready() && !processAlive(peerPid)) return false;
+        }
+    }
+
+    static void wake(std::atomic<std::uint32_t>& sleeping) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst) != 0) {
+            sleeping.store(0, std::memory_order_relaxed);
+            futexWakeAll(sleeping);
+        }
+    }
+
+public:
+    static constexpr std::size_t kMaxRecord = Capacity / 2 - sizeof(std::uint32_t);
+
+    // Запись из двух частей (заголовок и текст) без промежуточного буфера; false - в кольце нет места
+    bool tryWrite(std::string_view first, std::string_view second = {}) {
+        const std::size_t length = first.size() + second.size();
+        if (length > kMaxRecord) throw std::length_error("SpscRing: record too large");
+        const std::uint64_t position = head.load(std::memory_order_relaxed);
+        const std::uint64_t freeBytes = Capacity - (position - tail.load(std::memory_order_acquire));
+        const std::size_t offset = static_cast<std::size_t>(position % Capacity);
+        const std::size_t untilEnd = Capacity - offset;
+        const std::size_t size = recordSize(length);
+
+        std::uint64_t next = position;
+        std::size_t writeOffset = offset;
+        if (size > untilEnd) {
+            if (untilEnd + size > freeBytes) return false;
+            std::memcpy(data + offset, &kWrapMarker, sizeof(kWrapMarker));
+            next += untilEnd;
+            writeOffset = 0;
+        }
+        else if (size > freeBytes) {
+            return false;
+        }
+
+        const std::uint32_t storedLength = static_cast<std::uint32_t>(length);
+        std::memcpy(data + writeOffset, &storedLength, sizeof(storedLength));
+        std::memcpy(data + writeOffset + sizeof(storedLength), first.data(), first.size());
+        std::memcpy(data + writeOffset + sizeof(storedLength) + first.size(), second.data(), second.size());
+        head.store(next + size, std::memory_order_seq_cst);
+        wake(readerSleeping);
+        return true;
+    }
+
+    // Чтение одной записи в out; false - кольцо пусто.
+    // Память общая с другим процессом, поэтому длина и положение записи проверяются: при выходе за буфер
+    // или за записанные байты бросается исключение, а кольцо остается как было (см. discardAll)
+    bool tryRead(std::string& out) {
+        std::uint64_t position = tail.load(std::memory_order_relaxed);
+        const std::uint64_t end = head.load(std::memory_order_acquire);
+        if (position == end) return false;
+        if (end - position > Capacity) throw std::runtime_error("Shm error: corrupt ring");
+        std::size_t offset = static_cast<std::size_t>(position % Capacity);
+        std::uint32_t length = 0;
+        std::memcpy(&length, data + offset, sizeof(length));
+        if (length == kWrapMarker) {
+            position += Capacity - offset;
+            offset = 0;
+            if (position >= end) throw std::runtime_error("Shm error: corrupt ring");
+            std::memcpy(&length, data, sizeof(length));
+        }
+        if (length > kMaxRecord || offset + recordSize(length) > Capacity || recordSize(length) > end - position) {
+            throw std::runtime_error("Shm error: corrupt ring");
+        }
+        out.assign(reinterpret_cast<const char*>(data + offset + sizeof(length)), length);
+        tail.store(position + recordSize(length), std::memory_order_seq_cst);
+        wake(writerSleeping);
+        return true;
+    }
+
+    // Выбрасывает все записанное (для читателя, получившего "corrupt ring")
+    void discardAll() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_seq_cst);
+        wake(writerSleeping);
+    }
+
+    bool empty() const noexcept { return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire); }
+
+    // Ожидание записи; false - если выставлен cancel или завершился процесс peerPid
+    bool waitReadable(std::size_t spinCount, const std::atomic<bool>* cancel = nullptr, std::int32_t peerPid = 0) {
+        return waitFor(readerSleeping, spinCount, cancel, peerPid, [this] { return !empty(); });
+    }
+
+    void write(std::string_view first, std::string_view second, std::size_t spinCount, const std::atomic<bool>* cancel = nullptr) {
+        while (!tryWrite(first, second)) {
+            const std::size_t size = recordSize(first.size() + second.size());
+            // Место для записи с возможным маркером перехода
+            if (!waitFor(writerSleeping, spinCount, cancel, 0, [&] {
+                    return Capacity - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire)) >= 2 * size;
+                })) {
+                throw std::runtime_error("SpscRing: cancelled");
+            }
+        }
+    }
+
+    // Будит обе стороны, ждущие на этом кольце (для отмены)
+    void wakeAll() {
+        readerSleeping.store(0, std::memory_order_seq_cst);
+        writerSleeping.store(0, std::memory_order_seq_cst);
+        futexWakeAll(readerSleeping);
+        futexWakeAll(writerSleeping);
+    }
+};
+
+// Слот клиента в разделяемой памяти
+struct ShmSlot {
+    static constexpr std::size_t kRingBytes = 64 * 1024;
+
+    alignas(kCacheLine) std::atomic<std::int32_t> owner{ 0 };   // pid владельца; 0 - слот свободен
+    // Номера запросов продолжаются от владельца к владельцу: ответ прежнему не совпадет с новым номером
+    std::atomic<std::uint64_t> nextRequest{ 0 };
+    SpscRing<kRingBytes> requests;
+    SpscRing<kRingBytes> responses;
+};
+
+struct ShmRegion {
+    static constexpr std::uint64_t kMagic = 0x324d485352544c43ull;   // "CLTRSHM2"
+
+    std::uint64_t magic{ kMagic };
+    std::uint32_t slotCount{ 0 };
+    std::int32_t serverPid{ 0 };   // Клиенты не ждут ответа от завершившегося сервера
+    alignas(kCacheLine) std::atomic<bool> shuttingDown{ false };
+    ShmSlot slots[1];   // На самом деле slotCount слотов
+
+    static std::size_t bytesFor(std::uint32_t slotCount) {
+        return sizeof(ShmRegion) + (slotCount - 1) * sizeof(ShmSlot);
+    }
+};
+
+// Отображение POSIX shm; владелец создает объект и удаляет имя в деструкторе
+class ShmMapping {
+    void* address{ nullptr };
+    std::size_t length{ 0 };
+    std::string name;
+    bool owner{ false };
+
+public:
+    ShmMapping(const std::string& objectName, std::size_t bytes, bool create) : length(bytes), name(objectName), owner(create) {
+        int descriptor = create ? shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) : shm_open(name.c_str(), O_RDWR, 0);
+        if (descriptor < 0) throw std::runtime_error("Shm error: cannot open '" + name + "': " + std::strerror(errno));
+        if (create && ftruncate(descriptor, static_cast<off_t>(bytes)) != 0) {
+            ::close(descriptor);
+            shm_unlink(name.c_str());
+            throw std::runtime_error("Shm error: cannot size '" + name + "'");
+        }
+        if (!create) {
+            struct stat status;
+            if (fstat(descriptor, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(ShmRegion)) {
+                ::close(descriptor);
+                throw std::runtime_error("Shm error: '" + name + "' is not a translator region");
+            }
+            length = static_cast<std::size_t>(status.st_size);
+        }
+        address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        ::close(descriptor);
+        if (address == MAP_FAILED) {
+            if (create) shm_unlink(name.c_str());
+            throw std::runtime_error("Shm error: cannot map '" + name + "'");
+        }
+    }
+
+    ~ShmMapping() {
+        munmap(address, length);
+        if (owner) shm_unlink(name.c_str());
+    }
+
+    ShmMapping(const ShmMapping&) = delete;
+    ShmMapping& operator=(const ShmMapping&) = delete;
+
+    void* data() const noexcept { return address; }
+    std::size_t size() const noexcept { return length; }
+};
+
+// Формат записей: запрос - u64 номер и текст выражения;
+// ответ - u64 номер, байт статуса ('=' - значение double, '!' - текст ошибки) и данные
+class ShmEvaluationServer {
+    ShmMapping mapping;
+    ShmRegion* region;
+    std::vector<std::thread> workers;
+    std::size_t spinCount;
+
+    // Имя, оставшееся от аварийно завершенного сервера (наша сигнатура, процесса serverPid нет), удаляется,
+    // чтобы создать объект заново; чужой объект или объект живого сервера не трогается
+    static const std::string& unlinkStaleRegion(const std::string& name) {
+        try {
+            ShmMapping existing(name, 0, false);
+            const ShmRegion* stale = static_cast<const ShmRegion*>(existing.data());
+            if (stale->magic == ShmRegion::kMagic && stale->serverPid != 0 && !processAlive(stale->serverPid)) {
+                shm_unlink(name.c_str());
+            }
+        }
+        catch (const std::runtime_error&) {
+            // Объекта нет или он не наш: создание ниже сообщит об ошибке, если имя занято
+        }
+        return name;
+    }
+
+    void serveSlot(ShmSlot& slot) {
+        Translator translator;
+        translator.setLimits(EvaluationLimits::serverDefaults());
+        std::string request;
+        std::string response;
+        while (slot.requests.waitReadable(spinCount, &region->shuttingDown)) {
+            // Все накопившиеся запросы обрабатываются до следующего ожидания
+            for (;;) {
+                try {
+                    if (!slot.requests.tryRead(request)) break;
+                }
+                catch (const std::runtime_error&) {
+                    // Запись клиента выходит за кольцо: ее и все, что за ней, не разобрать; слот продолжает работу
+                    slot.requests.discardAll();
+                    break;
+                }
+                if (request.size() < sizeof(std::uint64_t)) continue;
+                response.assign(request, 0, sizeof(std::uint64_t));
+                try {
+                    double result = translator.calculate(request.substr(sizeof(std::uint64_t)));
+                    response += '=';
+                    response.append(reinterpret_cast<const char*>(&result), sizeof(result));
+                }
+                catch (const std::exception& e) {
+                    response += '!';
+                    response += e.what();
+                }
+                try {
+                    slot.responses.write(response, {}, spinCount, &region->shuttingDown);
+                }
+                catch (const std::runtime_error&) {
+                    return;   // Остановка сервера
+                }
+            }
+        }
+    }
+
+public:
+    // name - имя объекта shm ("/translator"); по одному потоку-вычислителю на слот
+    ShmEvaluationServer(const std::string& name, std::uint32_t slotCount, std::size_t spinIterations = defaultSpinCount())
+        : mapping(unlinkStaleRegion(name), ShmRegion::bytesFor(slotCount == 0 ? 1 : slotCount), true),
+          region(nullptr), spinCount(spinIterations) {
+        if (slotCount == 0) slotCount = 1;
+        // Память shm обнулена; конструируем объекты на месте
+        region = new (mapping.data()) ShmRegion();
+        for (std::uint32_t i = 1; i < slotCount; ++i) new (&region->slots[i]) ShmSlot();
+        region->slotCount = slotCount;
+        region->serverPid = static_cast<std::int32_t>(::getpid());
+    }
+
+    ~ShmEvaluationServer() {
+        stop();
+        for (std::thread& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    ShmEvaluationServer(const ShmEvaluationServer&) = delete;
+    ShmEvaluationServer& operator=(const ShmEvaluationServer&) = delete;
+
+    void start() {
+        for (std::uint32_t i = 0; i < region->slotCount; ++i) {
+            workers.emplace_back([this, i] { serveSlot(region->slots[i]); });
+        }
+    }
+
+    // Безопасно вызывать из обработчика сигнала
+    void stop() noexcept {
+        region->shuttingDown.store(true, std::memory_order_seq_cst);
+        for (std::uint32_t i = 0; i < region->slotCount; ++i) {
+            region->slots[i].requests.wakeAll();
+            region->slots[i].responses.wakeAll();
+        }
+    }
+
+    void wait() {
+        for (std::thread& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+};
+
+class ShmClient {
+    ShmMapping mapping;
+    ShmRegion* region;
+    ShmSlot* slot{ nullptr };
+    std::string response;
+    std::size_t spinCount;
+
+    [[noreturn]] void throwServerGone() const {
+        if (region->shuttingDown.load(std::memory_order_acquire)) throw std::runtime_error("Shm error: server is shutting down");
+        throw std::runtime_error("Shm error: server is not running");
+    }
+
+    // Свободный слот, иначе слот, владелец которого завершился, не освободив его (аварийно)
+    ShmSlot* claimSlot() {
+        const std::int32_t self = static_cast<std::int32_t>(::getpid());
+        for (std::uint32_t i = 0; i < region->slotCount; ++i) {
+            std::int32_t expected = 0;
+            if (region->slots[i].owner.compare_exchange_strong(expected, self)) return &region->slots[i];
+        }
+        for (std::uint32_t i = 0; i < region->slotCount; ++i) {
+            std::int32_t previous = region->slots[i].owner.load(std::memory_order_acquire);
+            if (previous != 0 && previous != self && !processAlive(previous) &&
+                region->slots[i].owner.compare_exchange_strong(previous, self)) {
+                return &region->slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Ответы прежнего владельца, которые уже лежат в кольце, не нужны
+    void discardResponses() {
+        while (slot->responses.tryRead(response)) {}
+    }
+
+public:
+    // Подключение к серверу: занимаем первый свободный слот или слот аварийно завершившегося клиента
+    explicit ShmClient(const std::string& name, std::size_t spinIterations = defaultSpinCount())
+        : mapping(name, 0, false), region(static_cast<ShmRegion*>(mapping.data())), spinCount(spinIterations) {
+        if (region->magic != ShmRegion::kMagic || ShmRegion::bytesFor(region->slotCount) > mapping.size()) {
+            throw std::runtime_error("Shm error: '" + name + "' is not a translator region");
+        }
+        if (!processAlive(region->serverPid)) throw std::runtime_error("Shm error: server is not running");
+        slot = claimSlot();
+        if (!slot) throw std::runtime_error("Shm error: no free client slots");
+        discardResponses();
+    }
+
+    ~ShmClient() {
+        slot->owner.store(0, std::memory_order_release);
+    }
+
+    ShmClient(const ShmClient&) = delete;
+    ShmClient& operator=(const ShmClient&) = delete;
+
+    double calculate(std::string_view expression) {
+        const std::uint64_t id = slot->nextRequest.fetch_add(1, std::memory_order_relaxed);
+        const std::string_view header(reinterpret_cast<const char*>(&id), sizeof(id));
+        // У клиента в работе один запрос, поэтому полное кольцо запросов - наследство прежнего владельца.
+        // Сервер может ждать места под ответы на них: ответы читаются и выбрасываются, пока запрос не записан
+        for (std::size_t attempt = 0; !slot->requests.tryWrite(header, expression); ++attempt) {
+            if (region->shuttingDown.load(std::memory_order_acquire)) throwServerGone();
+            discardResponses();
+            if (attempt < spinCount) {
+                cpuRelax();
+                continue;
+            }
+            if ((attempt - spinCount) % 2048 == 0 && !processAlive(region->serverPid)) throwServerGone();
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        for (;;) {
+            if (!slot->responses.waitReadable(spinCount, &region->shuttingDown, region->serverPid)) throwServerGone();
+            slot->responses.tryRead(response);
+            std::uint64_t responseId = 0;
+            if (response.size() <= sizeof(responseId)) continue;
+            std::memcpy(&responseId, response.data(), sizeof(responseId));
+            if (responseId != id) continue;   // Ответ на брошенный запрос или запрос прежнего владельца слота
+            if (response[sizeof(responseId)] == '!') throw std::runtime_error(response.substr(sizeof(responseId) + 1));
+            if (response.size() < sizeof(responseId) + 1 + sizeof(double)) throw std::runtime_error("Shm error: malformed response");
+            double result = 0.0;
+            std::memcpy(&result, response.data() + sizeof(responseId) + 1, sizeof(result));
+            return result;
+        }
+    }
+};
+#endif
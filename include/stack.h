@@ -1,30 +1,34 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <memory_resource>
 #include <stdexcept>
 
 namespace ds {
 
-    template <typename ElementType, template<typename...> class ContainerType = std::vector>
+    // Allocator передается контейнеру вторым параметром шаблона, поэтому
+    // ContainerType должен принимать (ElementType, Allocator), как std::vector и std::deque
+    template <typename ElementType,
+              template<typename...> class ContainerType = std::vector,
+              typename Allocator = std::allocator<ElementType>>
     class Stack {
     public:
+        using allocator_type = Allocator;
+
         Stack() = default;
-        Stack(const Stack& other) : elements(other.elements) {
-        }
-        Stack(Stack&& other) noexcept : elements(std::move(other.elements)) {
+        explicit Stack(const Allocator& alloc) : elements(alloc) {
         }
-        Stack& operator=(const Stack& other) {
-            if (this != &other) {
-                elements = other.elements;
-            }
-            return *this;
+        // Копия и перенос в память другого распределителя: так стек создается внутри pmr-контейнеров
+        Stack(const Stack& other, const Allocator& alloc) : elements(other.elements, alloc) {
         }
-        Stack& operator=(Stack&& other) noexcept {
-            if (this != &other) {
-                elements = std::move(other.elements);
-            }
-            return *this;
+        Stack(Stack&& other, const Allocator& alloc) : elements(std::move(other.elements), alloc) {
         }
+        Stack(const Stack& other) = default;
+        Stack(Stack&& other) noexcept = default;
+        // noexcept присваивания переносом - как у контейнера: при разных memory_resource элементы копируются
+        Stack& operator=(const Stack& other) = default;
+        Stack& operator=(Stack&& other) = default;
 
         void push(const ElementType& item) {
             elements.push_back(item);
@@ -63,9 +67,37 @@ namespace ds {
             return elements.size();
         }
 
+        // Удаляет элементы, но сохраняет выделенную память
+        void clear() noexcept {
+            elements.clear();
+        }
+
+        // reserve/capacity/shrink_to_fit доступны только для контейнеров, которые их поддерживают (std::vector)
+        void reserve(std::size_t count) {
+            elements.reserve(count);
+        }
+
+        std::size_t capacity() const noexcept {
+            return elements.capacity();
+        }
+
+        void shrink_to_fit() {
+            elements.shrink_to_fit();
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return elements.get_allocator();
+        }
+
     private:
-        ContainerType<ElementType> elements;
+        ContainerType<ElementType, Allocator> elements;
     };
 
+    namespace pmr {
+        // Стек поверх std::pmr::memory_resource (пулы, арены, заранее выделенные буферы)
+        template <typename ElementType, template<typename...> class ContainerType = std::vector>
+        using Stack = ds::Stack<ElementType, ContainerType, std::pmr::polymorphic_allocator<ElementType>>;
+    }
+
 }
 
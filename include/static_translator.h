@@ -0,0 +1,561 @@
+#pragma once
+#include <array>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <limits>
+#include "token.h"
+#include "lexer.h"
+#include "functions.h"
+
+// Вычисление выражений на этапе компиляции.
+// Те же правила, что у Lexer/Parcer/Eval, но на массивах фиксированной емкости,
+// поэтому все функции constexpr, а ошибки разбора в consteval-контексте становятся ошибками компиляции.
+// Числа записываются в десятичной форме (с необязательной экспонентой); шестнадцатеричные литералы не поддерживаются.
+
+struct StaticToken {
+    TokenType type{ TokenType::End };
+    char operatorChar{ '\0' };
+    double numericValue{ 0.0 };
+    std::size_t nameOffset{ 0 };   // Положение имени переменной во входной строке
+    std::size_t nameLength{ 0 };
+};
+
+// Скомпилированное выражение: последовательность RPN фиксированной емкости
+template <std::size_t Capacity>
+struct StaticProgram {
+    std::array<StaticToken, Capacity> tokens{};
+    std::size_t length{ 0 };
+
+    constexpr void push(const StaticToken& token) {
+        if (length >= Capacity) throw std::runtime_error("Parser error: expression too long");
+        tokens[length++] = token;
+    }
+
+    constexpr double evaluate() const;
+};
+
+// Большое целое без знака фиксированной емкости: точный перевод длинных чисел и больших порядков в double.
+// 4352 бит хватает на 801 значащую цифру при любом порядке, который не дает заведомо 0 или бесконечность
+class StaticBigInteger {
+    static constexpr std::size_t kLimbs = 136;
+    std::array<std::uint32_t, kLimbs> limbs{};
+    std::size_t size{ 0 };
+
+    constexpr void append(std::uint32_t limb) {
+        if (size >= kLimbs) throw std::runtime_error("Lexer error: number too long");
+        limbs[size++] = limb;
+    }
+
+public:
+    constexpr explicit StaticBigInteger(std::uint32_t value = 0) {
+        if (value != 0) append(value);
+    }
+
+    constexpr bool isZero() const { return size == 0; }
+
+    // this = this * factor + addend
+    constexpr void multiplyAdd(std::uint32_t factor, std::uint32_t addend) {
+        std::uint64_t carry = addend;
+        for (std::size_t i = 0; i < size; ++i) {
+            const std::uint64_t product = std::uint64_t{ limbs[i] } * factor + carry;
+            limbs[i] = static_cast<std::uint32_t>(product);
+            carry = product >> 32;
+        }
+        if (carry != 0) append(static_cast<std::uint32_t>(carry));
+    }
+
+    constexpr void multiplyByPowerOfTen(int exponent) {
+        for (; exponent >= 9; exponent -= 9) multiplyAdd(1000000000u, 0);
+        for (; exponent > 0; --exponent) multiplyAdd(10u, 0);
+    }
+
+    constexpr void shiftLeft(std::size_t bits) {
+        if (size == 0 || bits == 0) return;
+        const std::size_t limbShift = bits / 32, bitShift = bits % 32;
+        const std::uint32_t top = bitShift == 0 ? 0 : limbs[size - 1] >> (32 - bitShift);
+        if (size + limbShift + (top != 0) > kLimbs) throw std::runtime_error("Lexer error: number too long");
+        for (std::size_t i = size; i-- > 0;) {
+            const std::uint32_t lower = bitShift == 0 || i == 0 ? 0 : limbs[i - 1] >> (32 - bitShift);
+            limbs[i + limbShift] = (limbs[i] << bitShift) | lower;
+        }
+        for (std::size_t i = 0; i < limbShift; ++i) limbs[i] = 0;
+        size += limbShift;
+        if (top != 0) limbs[size++] = top;
+    }
+
+    constexpr void shiftRightOne() {
+        for (std::size_t i = 0; i < size; ++i) {
+            limbs[i] = (limbs[i] >> 1) | (i + 1 < size ? limbs[i + 1] << 31 : 0u);
+        }
+        if (size > 0 && limbs[size - 1] == 0) size--;
+    }
+
+    constexpr std::size_t bitLength() const {
+        if (size == 0) return 0;
+        std::size_t bits = (size - 1) * 32;
+        for (std::uint32_t top = limbs[size - 1]; top != 0; top >>= 1) bits++;
+        return bits;
+    }
+
+    constexpr int compare(const StaticBigInteger& other) const {
+        if (size != other.size) return size < other.size ? -1 : 1;
+        for (std::size_t i = size; i-- > 0;) {
+            if (limbs[i] != other.limbs[i]) return limbs[i] < other.limbs[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // this -= other, при условии this >= other
+    constexpr void subtract(const StaticBigInteger& other) {
+        std::int64_t borrow = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            std::int64_t difference = std::int64_t{ limbs[i] } - (i < other.size ? std::int64_t{ other.limbs[i] } : 0) - borrow;
+            borrow = difference < 0;
+            limbs[i] = static_cast<std::uint32_t>(difference + (borrow << 32));
+        }
+        while (size > 0 && limbs[size - 1] == 0) size--;
+    }
+};
+
+class StaticLexer {
+    std::string_view inputText;
+    std::size_t currentPosition{ 0 };
+    TokenType lastType{ TokenType::End };   // Для определения унарного минуса
+
+    static constexpr bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+
+    // Степень десяти, точная при exponent <= 22
+    static constexpr double powerOfTen(int exponent) {
+        double result = 1.0;
+        double base = 10.0;
+        unsigned magnitude = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+        while (magnitude != 0) {
+            if (magnitude & 1u) result *= base;
+            base *= base;
+            magnitude >>= 1;
+        }
+        return exponent < 0 ? 1.0 / result : result;
+    }
+
+    // Точное значение digits * 10^exponent с округлением к ближайшему четному, как у strtod.
+    // digits - цифры мантиссы с необязательной точкой; значение ищется как частное numerator / denominator,
+    // приведенное к 53 битам, по остатку которого выбирается направление округления
+    static constexpr double convertExactly(std::string_view digits, int exponent) {
+        // Хватает любого double: у точной десятичной записи не больше 767 значащих цифр.
+        // Отброшенные ненулевые цифры заменяются одной единицей в следующем разряде
+        constexpr int kMaxDigits = 800;
+        StaticBigInteger numerator;
+        int kept = 0;
+        bool afterPoint = false, truncated = false;
+        for (char ch : digits) {
+            if (ch == '.') {
+                afterPoint = true;
+                continue;
+            }
+            if (kept == 0 && ch == '0') {
+                if (afterPoint) exponent--;
+                continue;
+            }
+            if (kept < kMaxDigits) {
+                numerator.multiplyAdd(10u, static_cast<std::uint32_t>(ch - '0'));
+                kept++;
+                if (afterPoint) exponent--;
+            }
+            else {
+                truncated = truncated || ch != '0';
+                if (!afterPoint) exponent++;
+            }
+        }
+        if (numerator.isZero()) return 0.0;
+        if (truncated) {
+            numerator.multiplyAdd(10u, 1u);
+            kept++;
+            exponent--;
+        }
+        // Значение лежит в [10^(kept+exponent-1), 10^(kept+exponent))
+        if (kept + exponent > 310) return std::numeric_limits<double>::infinity();
+        if (kept + exponent < -325) return 0.0;
+
+        StaticBigInteger denominator(1u);
+        if (exponent >= 0) numerator.multiplyByPowerOfTen(exponent);
+        else denominator.multiplyByPowerOfTen(-exponent);
+
+        // Частное в [2^52, 2^53) после умножения на 2^-binaryExponent
+        int binaryExponent = static_cast<int>(numerator.bitLength()) - static_cast<int>(denominator.bitLength()) - 53;
+        if (binaryExponent < 0) numerator.shiftLeft(static_cast<std::size_t>(-binaryExponent));
+        else denominator.shiftLeft(static_cast<std::size_t>(binaryExponent));
+        StaticBigInteger shifted = denominator;
+        shifted.shiftLeft(53);
+        if (numerator.compare(shifted) >= 0) {
+            denominator.shiftLeft(1);
+            binaryExponent++;
+        }
+        // Денормализованный результат: меньше значащих бит, шаг 2^-1074
+        if (binaryExponent < -1074) {
+            denominator.shiftLeft(static_cast<std::size_t>(-1074 - binaryExponent));
+            binaryExponent = -1074;
+        }
+
+        std::uint64_t quotient = 0;
+        shifted = denominator;
+        shifted.shiftLeft(52);
+        for (int bit = 52; bit >= 0; --bit) {
+            if (numerator.compare(shifted) >= 0) {
+                numerator.subtract(shifted);
+                quotient |= std::uint64_t{ 1 } << bit;
+            }
+            shifted.shiftRightOne();
+        }
+        numerator.shiftLeft(1);
+        const int half = numerator.compare(denominator);
+        if (half > 0 || (half == 0 && (quotient & 1u) != 0)) quotient++;
+
+        // Округление могло дать 2^53 - на разряд больше
+        if (binaryExponent + (quotient >> 53 != 0 ? 53 : 52) > 1023) return std::numeric_limits<double>::infinity();
+        // Умножение на степени двойки точно: результат и все промежуточные значения представимы
+        double value = static_cast<double>(quotient);
+        for (; binaryExponent > 0; --binaryExponent) value *= 2.0;
+        for (; binaryExponent < 0; ++binaryExponent) value *= 0.5;
+        return value;
+    }
+
+    // Разбор числа в форме digits[.digits][(e|E)[+-]digits]; результат совпадает с strtod.
+    // Мантисса до 2^53 при |порядке| <= 22 переводится одним умножением или делением, остальное - convertExactly
+    constexpr double parseNumber() {
+        const std::size_t numberStart = currentPosition;
+        std::uint64_t mantissa = 0;
+        int significantDigits = 0;
+        int decimalExponent = 0;
+        bool anyDigits = false;
+
+        while (currentPosition < inputText.size() && isDigit(inputText[currentPosition])) {
+            anyDigits = true;
+            if (significantDigits < 19) {
+                mantissa = mantissa * 10 + static_cast<std::uint64_t>(inputText[currentPosition] - '0');
+                if (mantissa != 0) significantDigits++;
+            }
+            else {
+                decimalExponent++;
+            }
+            currentPosition++;
+        }
+        if (currentPosition < inputText.size() && inputText[currentPosition] == '.') {
+            currentPosition++;
+            while (currentPosition < inputText.size() && isDigit(inputText[currentPosition])) {
+                anyDigits = true;
+                if (significantDigits < 19) {
+                    mantissa = mantissa * 10 + static_cast<std::uint64_t>(inputText[currentPosition] - '0');
+                    if (mantissa != 0) significantDigits++;
+                    decimalExponent--;
+                }
+                currentPosition++;
+            }
+        }
+        if (!anyDigits) throw std::runtime_error("Lexer error: invalid number");
+        const std::string_view digits = inputText.substr(numberStart, currentPosition - numberStart);
+
+        // Экспонента учитывается, только если за ней следуют цифры (как в strtod)
+        int exponentValue = 0;
+        if (currentPosition < inputText.size() && (inputText[currentPosition] == 'e' || inputText[currentPosition] == 'E')) {
+            std::size_t lookahead = currentPosition + 1;
+            bool negative = false;
+            if (lookahead < inputText.size() && (inputText[lookahead] == '+' || inputText[lookahead] == '-')) {
+                negative = inputText[lookahead] == '-';
+                lookahead++;
+            }
+            if (lookahead < inputText.size() && isDigit(inputText[lookahead])) {
+                while (lookahead < inputText.size() && isDigit(inputText[lookahead])) {
+                    if (exponentValue < 10000) exponentValue = exponentValue * 10 + (inputText[lookahead] - '0');
+                    lookahead++;
+                }
+                if (negative) exponentValue = -exponentValue;
+                decimalExponent += exponentValue;
+                currentPosition = lookahead;
+            }
+        }
+
+        if (mantissa == 0) return 0.0;
+        if (mantissa <= (std::uint64_t{ 1 } << 53) && decimalExponent >= -22 && decimalExponent <= 22) {
+            const double value = static_cast<double>(mantissa);
+            return decimalExponent < 0 ? value / powerOfTen(-decimalExponent) : value * powerOfTen(decimalExponent);
+        }
+        return convertExactly(digits, exponentValue);
+    }
+
+    constexpr bool canBeUnaryMinus() const {
+        return lastType == TokenType::End || lastType == TokenType::Operator || lastType == TokenType::LeftParen;
+    }
+
+    constexpr StaticToken remember(StaticToken token) {
+        lastType = token.type;
+        return token;
+    }
+
+public:
+    constexpr explicit StaticLexer(std::string_view input) : inputText(input) {}
+
+    constexpr StaticToken getNextToken() {
+        while (currentPosition < inputText.size() && Lexer::isWhitespace(inputText[currentPosition])) {
+            currentPosition++;
+        }
+        if (currentPosition >= inputText.size()) {
+            return remember(StaticToken{});
+        }
+
+        char currentChar = inputText[currentPosition];
+        if (currentChar == '(') {
+            currentPosition++;
+            return remember(StaticToken{ TokenType::LeftParen, '(', 0.0 });
+        }
+        if (currentChar == ')') {
+            currentPosition++;
+            return remember(StaticToken{ TokenType::RightParen, ')', 0.0 });
+        }
+        if (Lexer::isValidOperator(currentChar)) {
+            currentPosition++;
+            if (currentChar == '-' && canBeUnaryMinus()) {
+                return remember(StaticToken{ TokenType::Operator, '~', 0.0 });
+            }
+            return remember(StaticToken{ TokenType::Operator, currentChar, 0.0 });
+        }
+        if (isDigit(currentChar) || currentChar == '.') {
+            double numValue = parseNumber();
+            return remember(StaticToken{ TokenType::Number, '\0', numValue });
+        }
+        if (Lexer::isIdentifierStart(currentChar)) {
+            std::size_t nameStart = currentPosition;
+            while (currentPosition < inputText.size() && Lexer::isIdentifierChar(inputText[currentPosition])) {
+                currentPosition++;
+            }
+            return remember(StaticToken{ TokenType::Identifier, '\0', 0.0, nameStart, currentPosition - nameStart });
+        }
+
+        throw std::runtime_error("Lexer error: unexpected character");
+    }
+};
+
+// Shunting Yard с теми же приоритетами, что у Parcer
+class StaticParcer {
+public:
+    template <std::size_t Capacity>
+    static constexpr StaticProgram<Capacity> toRpn(StaticLexer& lex) {
+        StaticProgram<Capacity> outputQueue;
+        std::array<StaticToken, Capacity> operatorStack{};
+        std::size_t stackSize = 0;
+
+        auto pushOperator = [&](const StaticToken& token) {
+            if (stackSize >= Capacity) throw std::runtime_error("Parser error: expression too long");
+            operatorStack[stackSize++] = token;
+        };
+
+        bool expectingOperand = true;
+        for (;;) {
+            StaticToken currentToken = lex.getNextToken();
+
+            if (expectingOperand) {
+                if (currentToken.type == TokenType::Number || currentToken.type == TokenType::Identifier) {
+                    outputQueue.push(currentToken);
+                    expectingOperand = false;
+                    continue;
+                }
+                if (currentToken.type == TokenType::LeftParen ||
+                    (currentToken.type == TokenType::Operator && currentToken.operatorChar == '~')) {
+                    pushOperator(currentToken);
+                    continue;
+                }
+                throw std::runtime_error("Parser error: operand expected");
+            }
+
+            if (currentToken.type == TokenType::Operator) {
+                int currentPrec = operatorPrecedence(currentToken.operatorChar);
+                while (stackSize > 0 && operatorStack[stackSize - 1].type == TokenType::Operator) {
+                    int stackPrec = operatorPrecedence(operatorStack[stackSize - 1].operatorChar);
+                    if (stackPrec > currentPrec || (stackPrec == currentPrec && !isRightAssociativeOperator(currentToken.operatorChar))) {
+                        outputQueue.push(operatorStack[--stackSize]);
+                    }
+                    else {
+                        break;
+                    }
+                }
+                pushOperator(currentToken);
+                expectingOperand = true;
+                continue;
+            }
+
+            if (currentToken.type == TokenType::RightParen) {
+                bool matchingLeftFound = false;
+                while (stackSize > 0) {
+                    StaticToken stackTop = operatorStack[--stackSize];
+                    if (stackTop.type == TokenType::LeftParen) {
+                        matchingLeftFound = true;
+                        break;
+                    }
+                    outputQueue.push(stackTop);
+                }
+                if (!matchingLeftFound) throw std::runtime_error("Parser error: ')' without matching '('");
+                continue;
+            }
+
+            if (currentToken.type == TokenType::End) {
+                while (stackSize > 0) {
+                    StaticToken stackTop = operatorStack[--stackSize];
+                    if (stackTop.type == TokenType::LeftParen) {
+                        throw std::runtime_error("Parser error: '(' without matching ')'");
+                    }
+                    outputQueue.push(stackTop);
+                }
+                return outputQueue;
+            }
+
+            throw std::runtime_error("Parser error: operator expected");
+        }
+    }
+};
+
+class StaticEval {
+    // Произведение a * b представимо без округления (разложение Вельткампа - Деккера).
+    // Порядки ограничены, чтобы разложение не переполнилось и не ушло в денормалы
+    static constexpr bool exactProduct(double a, double b) {
+        constexpr double kSplitter = 134217729.0;   // 2^27 + 1
+        constexpr double kMaxMagnitude = 0x1p500, kMinMagnitude = 0x1p-400;
+        if (a == 0.0 || b == 0.0) return true;
+        for (double value : { a, b }) {
+            const double magnitude = value < 0 ? -value : value;
+            if (magnitude > kMaxMagnitude || magnitude < kMinMagnitude) return false;
+        }
+        const double product = a * b;
+        const double aScaled = kSplitter * a, bScaled = kSplitter * b;
+        const double aHigh = aScaled - (aScaled - a), aLow = a - aHigh;
+        const double bHigh = bScaled - (bScaled - b), bLow = b - bHigh;
+        return ((aHigh * bHigh - product) + aHigh * bLow + aLow * bHigh) + aLow * bLow == 0.0;
+    }
+
+    // integerPower, если все его умножения (и обратная величина) точны; тогда pow дает то же значение
+    static constexpr bool exactIntegerPower(double base, int exponent, double& result) {
+        unsigned magnitude = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+        double value = 1.0;
+        while (magnitude != 0) {
+            if (magnitude & 1u) {
+                if (!exactProduct(value, base)) return false;
+                value *= base;
+            }
+            magnitude >>= 1;
+            if (magnitude != 0) {
+                if (!exactProduct(base, base)) return false;
+                base *= base;
+            }
+        }
+        if (exponent < 0) {
+            // Обратная величина точна только у степени двойки
+            if (value == 0.0 || !exactProduct(value, 1.0 / value) || value * (1.0 / value) != 1.0) return false;
+            value = 1.0 / value;
+        }
+        result = value;
+        return true;
+    }
+
+public:
+    template <std::size_t Capacity>
+    static constexpr double evaluateRpn(const StaticProgram<Capacity>& program) {
+        std::array<double, Capacity> valueStack{};
+        std::size_t stackSize = 0;
+
+        for (std::size_t i = 0; i < program.length; ++i) {
+            const StaticToken& token = program.tokens[i];
+            if (token.type == TokenType::Number) {
+                valueStack[stackSize++] = token.numericValue;
+                continue;
+            }
+            if (token.type == TokenType::Identifier) {
+                throw std::runtime_error("Eval error: unbound variable");
+            }
+            if (token.type != TokenType::Operator) {
+                throw std::runtime_error("Eval error: unexpected token in RPN");
+            }
+            if (token.operatorChar == '~') {
+                if (stackSize < 1) throw std::runtime_error("Eval error: unary minus needs 1 operand");
+                valueStack[stackSize - 1] = -valueStack[stackSize - 1];
+                continue;
+            }
+            if (stackSize < 2) throw std::runtime_error("Eval error: binary operator needs 2 operands");
+
+            double rightOperand = valueStack[--stackSize];
+            double leftOperand = valueStack[stackSize - 1];
+            switch (token.operatorChar) {
+            case '+': valueStack[stackSize - 1] = leftOperand + rightOperand; break;
+            case '-': valueStack[stackSize - 1] = leftOperand - rightOperand; break;
+            case '*': valueStack[stackSize - 1] = leftOperand * rightOperand; break;
+            case '/':
+                if (rightOperand == 0.0) throw std::runtime_error("Eval error: division by zero");
+                valueStack[stackSize - 1] = leftOperand / rightOperand;
+                break;
+            case '^': {
+                // Как в Eval: литерал-целый показатель считается умножениями, остальное - через pow.
+                // pow не constexpr, поэтому на этапе компиляции вычисленный показатель допустим, только если
+                // степень точна: pow вернет то же значение (ошибка pow меньше половины ulp с запасом)
+                const bool rightIsLiteral = i > 0 && program.tokens[i - 1].type == TokenType::Number;
+                double power = 0.0;
+                if (rightIsLiteral && isSmallIntegerExponent(rightOperand)) {
+                    valueStack[stackSize - 1] = integerPower(leftOperand, static_cast<int>(rightOperand));
+                }
+                else if (!std::is_constant_evaluated()) {
+                    valueStack[stackSize - 1] = applyMathFunction(MathFunction::Pow, leftOperand, rightOperand);
+                }
+                else if (!isSmallIntegerExponent(rightOperand)) {
+                    throw std::runtime_error("Eval error: non-integer exponent in constant expression");
+                }
+                else if (exactIntegerPower(leftOperand, static_cast<int>(rightOperand), power)) {
+                    valueStack[stackSize - 1] = power;
+                }
+                else {
+                    throw std::runtime_error("Eval error: inexact power in constant expression");
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("Eval error: unknown operator");
+            }
+        }
+
+        if (stackSize != 1) throw std::runtime_error("Eval error: invalid expression");
+        return valueStack[0];
+    }
+};
+
+template <std::size_t Capacity>
+constexpr double StaticProgram<Capacity>::evaluate() const {
+    return StaticEval::evaluateRpn(*this);
+}
+
+class StaticTranslator {
+public:
+    // Емкость по умолчанию для выражений, длина которых не известна как константа
+    static constexpr std::size_t kDefaultCapacity = 256;
+
+    template <std::size_t Capacity = kDefaultCapacity>
+    static constexpr StaticProgram<Capacity> compile(std::string_view expression) {
+        StaticLexer tokenizer(expression);
+        return StaticParcer::toRpn<Capacity>(tokenizer);
+    }
+
+    template <std::size_t Capacity = kDefaultCapacity>
+    static constexpr double calculate(std::string_view expression) {
+        return compile<Capacity>(expression).evaluate();
+    }
+};
+
+// Компиляция строкового литерала в RPN на этапе компиляции; емкость равна длине литерала
+template <std::size_t Length>
+consteval StaticProgram<Length> compileStatic(const char (&expression)[Length]) {
+    return StaticTranslator::compile<Length>(std::string_view(expression, Length - 1));
+}
+
+namespace translator::literals {
+    // "2+3*4"_calc - значение выражения, вычисленное компилятором
+    consteval double operator""_calc(const char* expression, std::size_t length) {
+        return StaticTranslator::calculate(std::string_view(expression, length));
+    }
+}
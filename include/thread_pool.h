@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+// Пул потоков фиксированного размера
+class ThreadPool {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping{ false };
+
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    // Общее состояние parallelFor; живет, пока его держит хотя бы один помощник
+    struct RangeState {
+        std::function<void(std::size_t, std::size_t)> body;
+        std::size_t count{ 0 };
+        std::size_t chunkSize{ 1 };
+        std::size_t chunkCount{ 0 };
+        std::atomic<std::size_t> nextChunk{ 0 };
+        std::size_t finishedChunks{ 0 };
+        std::exception_ptr firstError;
+        std::mutex stateMutex;
+        std::condition_variable finished;
+
+        // Забираем куски, пока они есть; тело вызывается только для реально взятых кусков
+        void runChunks() {
+            for (;;) {
+                std::size_t chunk = nextChunk.fetch_add(1);
+                if (chunk >= chunkCount) return;
+                std::size_t begin = chunk * chunkSize;
+                std::size_t end = std::min(count, begin + chunkSize);
+                std::exception_ptr error;
+                try {
+                    body(begin, end);
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (error && !firstError) firstError = error;
+                if (++finishedChunks == chunkCount) finished.notify_all();
+            }
+        }
+    };
+
+public:
+    explicit ThreadPool(std::size_t threadCount = std::max<std::size_t>(1, std::thread::hardware_concurrency())) {
+        workers.reserve(threadCount);
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueCondition.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    std::size_t size() const noexcept { return workers.size(); }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            tasks.push_back(std::move(task));
+        }
+        queueCondition.notify_one();
+    }
+
+    // Делит [0, count) на куски и обрабатывает их в пуле и в вызывающем потоке.
+    // body(begin, end) вызывается для каждого куска; первое исключение пробрасывается после завершения всех кусков.
+    // Ожидаются куски, а не потоки, поэтому вложенный вызов из задачи пула не блокируется.
+    void parallelFor(std::size_t count, std::function<void(std::size_t, std::size_t)> body, std::size_t minChunk = 1) {
+        if (count == 0) return;
+        auto state = std::make_shared<RangeState>();
+        state->body = std::move(body);
+        state->count = count;
+        std::size_t targetChunks = std::max<std::size_t>(1, (workers.size() + 1) * 4);
+        state->chunkSize = std::max(std::max<std::size_t>(1, minChunk), (count + targetChunks - 1) / targetChunks);
+        state->chunkCount = (count + state->chunkSize - 1) / state->chunkSize;
+
+        std::size_t helpers = std::min(workers.size(), state->chunkCount - 1);
+        for (std::size_t i = 0; i < helpers; ++i) {
+            submit([state] { state->runChunks(); });
+        }
+        state->runChunks();
+
+        std::unique_lock<std::mutex> lock(state->stateMutex);
+        state->finished.wait(lock, [&] { return state->finishedChunks == state->chunkCount; });
+        if (state->firstError) std::rethrow_exception(state->firstError);
+    }
+};
@@ -0,0 +1,264 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include "program.h"
+#include "functions.h"
+
+// Интерпретатор с шитым кодом. Каждая инструкция хранит адрес своего обработчика (computed goto в GCC/Clang),
+// и переход к следующей инструкции - отдельная косвенная ветвь в конце каждого обработчика,
+// а не одна общая ветвь switch, поэтому предсказатель видит пары "операция -> следующая операция".
+// Частые пары байткода сливаются в суперинструкции. Набор выбран по профилю пар (bench_dispatch):
+// константа или переменная как правый операнд +, -, * и унарный минус перед умножением.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(TRANSLATOR_NO_COMPUTED_GOTO)
+#define TRANSLATOR_COMPUTED_GOTO 1
+#else
+#define TRANSLATOR_COMPUTED_GOTO 0
+#endif
+
+enum class ThreadedOp : std::uint8_t {
+    PushConstant,
+    PushVariable,
+    Negate,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    DivideConstant,
+    Power,
+    PowerInt,
+    Call,
+    AddConstant,        // PushConstant + Add
+    SubtractConstant,   // PushConstant + Subtract
+    MultiplyConstant,   // PushConstant + Multiply
+    AddVariable,        // PushVariable + Add
+    SubtractVariable,   // PushVariable + Subtract
+    MultiplyVariable,   // PushVariable + Multiply
+    NegateMultiply,     // Negate + Multiply
+    Return
+};
+
+inline constexpr std::size_t kThreadedOpCount = static_cast<std::size_t>(ThreadedOp::Return) + 1;
+
+struct ThreadedInstruction {
+    const void* handler{ nullptr };   // Адрес обработчика; заполняется только при computed goto
+    ThreadedOp op{ ThreadedOp::Return };
+    std::uint32_t operand{ 0 };       // Слот переменной, показатель PowerInt или MathFunction
+    double immediate{ 0.0 };          // Константа прямо в инструкции, без обращения к пулу
+};
+
+struct ThreadedProgram {
+    std::vector<ThreadedInstruction> code;   // Заканчивается Return
+    std::vector<std::string> variables;
+    std::size_t stackDepth{ 0 };
+};
+
+class ThreadedEval {
+    std::vector<double> stack;
+
+    // Единственная функция, где определены метки обработчиков: с program == nullptr возвращает их таблицу
+    static double run(const ThreadedProgram* program, const double* variables, double* stackBase, const void* const** handlers) {
+#if TRANSLATOR_COMPUTED_GOTO
+        static const void* const table[kThreadedOpCount] = {
+            &&PushConstant, &&PushVariable, &&Negate, &&Add, &&Subtract, &&Multiply, &&Divide, &&DivideConstant,
+            &&Power, &&PowerInt, &&Call, &&AddConstant, &&SubtractConstant, &&MultiplyConstant,
+            &&AddVariable, &&SubtractVariable, &&MultiplyVariable, &&NegateMultiply, &&Return
+        };
+        if (!program) {
+            *handlers = table;
+            return 0.0;
+        }
+
+        const ThreadedInstruction* ip = program->code.data();
+        double* sp = stackBase;   // Следующая свободная ячейка; вершина - sp[-1]
+#define THREADED_NEXT goto *(++ip)->handler
+        goto *ip->handler;
+
+    PushConstant: *sp++ = ip->immediate; THREADED_NEXT;
+    PushVariable: *sp++ = variables[ip->operand]; THREADED_NEXT;
+    Negate: sp[-1] = -sp[-1]; THREADED_NEXT;
+    Add: --sp; sp[-1] = sp[-1] + sp[0]; THREADED_NEXT;
+    Subtract: --sp; sp[-1] = sp[-1] - sp[0]; THREADED_NEXT;
+    Multiply: --sp; sp[-1] = sp[-1] * sp[0]; THREADED_NEXT;
+    Divide:
+        --sp;
+        if (sp[0] == 0.0) throw std::runtime_error("Eval error: division by zero");
+        sp[-1] = sp[-1] / sp[0];
+        THREADED_NEXT;
+    DivideConstant: sp[-1] = sp[-1] / ip->immediate; THREADED_NEXT;
+    Power: --sp; sp[-1] = applyMathFunction(MathFunction::Pow, sp[-1], sp[0]); THREADED_NEXT;
+    PowerInt: sp[-1] = integerPower(sp[-1], static_cast<std::int32_t>(ip->operand)); THREADED_NEXT;
+    Call: {
+        MathFunction function = static_cast<MathFunction>(ip->operand);
+        if (mathFunctionInfo(function).arity == 2) {
+            --sp;
+            sp[-1] = applyMathFunction(function, sp[-1], sp[0]);
+        }
+        else {
+            sp[-1] = applyMathFunction(function, sp[-1]);
+        }
+        THREADED_NEXT;
+    }
+    AddConstant: sp[-1] = sp[-1] + ip->immediate; THREADED_NEXT;
+    SubtractConstant: sp[-1] = sp[-1] - ip->immediate; THREADED_NEXT;
+    MultiplyConstant: sp[-1] = sp[-1] * ip->immediate; THREADED_NEXT;
+    AddVariable: sp[-1] = sp[-1] + variables[ip->operand]; THREADED_NEXT;
+    SubtractVariable: sp[-1] = sp[-1] - variables[ip->operand]; THREADED_NEXT;
+    MultiplyVariable: sp[-1] = sp[-1] * variables[ip->operand]; THREADED_NEXT;
+    NegateMultiply: --sp; sp[-1] = sp[-1] * -sp[0]; THREADED_NEXT;
+    Return: return sp[-1];
+#undef THREADED_NEXT
+#else
+        if (!program) {
+            *handlers = nullptr;
+            return 0.0;
+        }
+        return runSwitch(*program, variables, stackBase);
+#endif
+    }
+
+public:
+    // Переносимый вариант с одной точкой диспетчеризации: тот же код, тот же результат
+    static double runSwitch(const ThreadedProgram& program, const double* variables, double* stackBase) {
+        double* sp = stackBase;
+        for (const ThreadedInstruction* ip = program.code.data();; ++ip) {
+            switch (ip->op) {
+            case ThreadedOp::PushConstant: *sp++ = ip->immediate; break;
+            case ThreadedOp::PushVariable: *sp++ = variables[ip->operand]; break;
+            case ThreadedOp::Negate: sp[-1] = -sp[-1]; break;
+            case ThreadedOp::Add: --sp; sp[-1] = sp[-1] + sp[0]; break;
+            case ThreadedOp::Subtract: --sp; sp[-1] = sp[-1] - sp[0]; break;
+            case ThreadedOp::Multiply: --sp; sp[-1] = sp[-1] * sp[0]; break;
+            case ThreadedOp::Divide:
+                --sp;
+                if (sp[0] == 0.0) throw std::runtime_error("Eval error: division by zero");
+                sp[-1] = sp[-1] / sp[0];
+                break;
+            case ThreadedOp::DivideConstant: sp[-1] = sp[-1] / ip->immediate; break;
+            case ThreadedOp::Power: --sp; sp[-1] = applyMathFunction(MathFunction::Pow, sp[-1], sp[0]); break;
+            case ThreadedOp::PowerInt: sp[-1] = integerPower(sp[-1], static_cast<std::int32_t>(ip->operand)); break;
+            case ThreadedOp::Call: {
+                MathFunction function = static_cast<MathFunction>(ip->operand);
+                if (mathFunctionInfo(function).arity == 2) {
+                    --sp;
+                    sp[-1] = applyMathFunction(function, sp[-1], sp[0]);
+                }
+                else {
+                    sp[-1] = applyMathFunction(function, sp[-1]);
+                }
+                break;
+            }
+            case ThreadedOp::AddConstant: sp[-1] = sp[-1] + ip->immediate; break;
+            case ThreadedOp::SubtractConstant: sp[-1] = sp[-1] - ip->immediate; break;
+            case ThreadedOp::MultiplyConstant: sp[-1] = sp[-1] * ip->immediate; break;
+            case ThreadedOp::AddVariable: sp[-1] = sp[-1] + variables[ip->operand]; break;
+            case ThreadedOp::SubtractVariable: sp[-1] = sp[-1] - variables[ip->operand]; break;
+            case ThreadedOp::MultiplyVariable: sp[-1] = sp[-1] * variables[ip->operand]; break;
+            case ThreadedOp::NegateMultiply: --sp; sp[-1] = sp[-1] * -sp[0]; break;
+            case ThreadedOp::Return: return sp[-1];
+            default: throw std::runtime_error("Eval error: unknown instruction");
+            }
+        }
+    }
+
+    static bool hasComputedGoto() noexcept { return TRANSLATOR_COMPUTED_GOTO != 0; }
+
+    // Перевод байткода в шитый код; superinstructions = false оставляет инструкции один к одному
+    static ThreadedProgram compile(const Program& program, bool superinstructions = true) {
+        ThreadedProgram threaded;
+        threaded.variables = program.variables;
+        threaded.code.reserve(program.code.size() + 1);
+
+        const std::vector<Instruction>& code = program.code;
+        for (std::size_t i = 0; i < code.size(); ++i) {
+            const Instruction& instruction = code[i];
+            const OpCode next = i + 1 < code.size() ? code[i + 1].opCode : OpCode::PushConstant;
+            const bool fuseNext = superinstructions && i + 1 < code.size() &&
+                                  (next == OpCode::Add || next == OpCode::Subtract || next == OpCode::Multiply);
+            ThreadedInstruction emitted;
+            emitted.operand = instruction.operand;
+
+            switch (instruction.opCode) {
+            case OpCode::PushConstant:
+                emitted.immediate = program.constants[instruction.operand];
+                emitted.op = !fuseNext ? ThreadedOp::PushConstant
+                           : next == OpCode::Add ? ThreadedOp::AddConstant
+                           : next == OpCode::Subtract ? ThreadedOp::SubtractConstant : ThreadedOp::MultiplyConstant;
+                break;
+            case OpCode::PushVariable:
+                emitted.op = !fuseNext ? ThreadedOp::PushVariable
+                           : next == OpCode::Add ? ThreadedOp::AddVariable
+                           : next == OpCode::Subtract ? ThreadedOp::SubtractVariable : ThreadedOp::MultiplyVariable;
+                break;
+            case OpCode::Negate:
+                emitted.op = superinstructions && next == OpCode::Multiply && i + 1 < code.size()
+                           ? ThreadedOp::NegateMultiply : ThreadedOp::Negate;
+                break;
+            case OpCode::Add: emitted.op = ThreadedOp::Add; break;
+            case OpCode::Subtract: emitted.op = ThreadedOp::Subtract; break;
+            case OpCode::Multiply: emitted.op = ThreadedOp::Multiply; break;
+            case OpCode::Divide: emitted.op = ThreadedOp::Divide; break;
+            case OpCode::DivideConstant:
+                emitted.op = ThreadedOp::DivideConstant;
+                emitted.immediate = program.constants[instruction.operand];
+                break;
+            case OpCode::Power: emitted.op = ThreadedOp::Power; break;
+            case OpCode::PowerInt: emitted.op = ThreadedOp::PowerInt; break;
+            case OpCode::Call: emitted.op = ThreadedOp::Call; break;
+            default: throw std::runtime_error("Compiler error: unknown instruction");
+            }
+            // Суперинструкция поглощает следующую инструкцию
+            if (emitted.op >= ThreadedOp::AddConstant) i++;
+            threaded.code.push_back(emitted);
+        }
+        threaded.code.push_back(ThreadedInstruction{});
+
+        // Глубина по шитому коду: слияние убирает промежуточные вершины стека
+        std::size_t depth = 0;
+        for (const ThreadedInstruction& instruction : threaded.code) {
+            switch (instruction.op) {
+            case ThreadedOp::PushConstant:
+            case ThreadedOp::PushVariable:
+                depth++;
+                break;
+            case ThreadedOp::Add:
+            case ThreadedOp::Subtract:
+            case ThreadedOp::Multiply:
+            case ThreadedOp::Divide:
+            case ThreadedOp::Power:
+            case ThreadedOp::NegateMultiply:
+                depth--;
+                break;
+            case ThreadedOp::Call:
+                depth -= mathFunctionInfo(static_cast<MathFunction>(instruction.operand)).arity - 1;
+                break;
+            default:
+                break;
+            }
+            if (depth > threaded.stackDepth) threaded.stackDepth = depth;
+        }
+
+        const void* const* handlers = nullptr;
+        run(nullptr, nullptr, nullptr, &handlers);
+        if (handlers) {
+            for (ThreadedInstruction& instruction : threaded.code) instruction.handler = handlers[static_cast<std::size_t>(instruction.op)];
+        }
+        return threaded;
+    }
+
+    double evaluate(const ThreadedProgram& program, const double* variables) {
+        if (stack.size() < program.stackDepth) stack.resize(program.stackDepth);
+#if TRANSLATOR_COMPUTED_GOTO
+        return run(&program, variables, stack.data(), nullptr);
+#else
+        return runSwitch(program, variables, stack.data());
+#endif
+    }
+
+    double evaluateSwitch(const ThreadedProgram& program, const double* variables) {
+        if (stack.size() < program.stackDepth) stack.resize(program.stackDepth);
+        return runSwitch(program, variables, stack.data());
+    }
+};
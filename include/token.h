@@ -1,11 +1,16 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
 
-enum class TokenType {
+enum class TokenType : std::uint8_t {
     Number,
+    Identifier,  // Имя переменной
+    Function,    // Имя функции, за которым следует '('
     Operator,    // ~ для унарного минуса
     LeftParen,
     RightParen,
+    Comma,       // Разделитель аргументов функции
     End
 };
 
@@ -24,6 +29,20 @@ struct Token {
         return result;
     }
 
+    static Token createIdentifier(std::string name) {
+        Token result;
+        result.type = TokenType::Identifier;
+        result.content = std::move(name);
+        return result;
+    }
+
+    static Token createFunction(std::string name) {
+        Token result;
+        result.type = TokenType::Function;
+        result.content = std::move(name);
+        return result;
+    }
+
     static Token createOperator(char op) {
         Token result;
         result.type = TokenType::Operator;
@@ -45,9 +64,74 @@ struct Token {
         return result;
     }
 
+    static Token createComma() {
+        Token result;
+        result.type = TokenType::Comma;
+        result.content = ",";
+        return result;
+    }
+
     static Token createEnd() {
         return Token{};
     }
 
     char getOperatorChar() const { return content.empty() ? '\0' : content[0]; }
-};
\ No newline at end of file
+};
+
+// Токены всего выражения столбцами (Lexer::tokenizeAll): парсер читает их по индексу, без копий Token
+struct TokenBuffer {
+    std::vector<TokenType> types;
+    std::vector<char> operators;         // Символ оператора ('~' - унарный минус), иначе '\0'
+    std::vector<double> values;          // Значение числа
+    std::vector<std::uint32_t> offsets;  // Начало токена в исходной строке
+    std::vector<std::uint32_t> lengths;
+    // Ошибка лексера. Последний токен тогда End на месте ошибки: парсер сообщит ее,
+    // только дойдя до этого места, как при поочередном чтении токенов
+    std::string error;
+
+    std::size_t size() const noexcept { return types.size(); }
+    bool empty() const noexcept { return types.empty(); }
+    std::size_t capacity() const noexcept { return types.capacity(); }
+
+    void push(TokenType type, char op, double value, std::size_t offset, std::size_t length) {
+        types.push_back(type);
+        operators.push_back(op);
+        values.push_back(value);
+        offsets.push_back(static_cast<std::uint32_t>(offset));
+        lengths.push_back(static_cast<std::uint32_t>(length));
+    }
+
+    void clear() {
+        types.clear();
+        operators.clear();
+        values.clear();
+        offsets.clear();
+        lengths.clear();
+        error.clear();
+    }
+
+    void shrink_to_fit() {
+        types.shrink_to_fit();
+        operators.shrink_to_fit();
+        values.shrink_to_fit();
+        offsets.shrink_to_fit();
+        lengths.shrink_to_fit();
+    }
+};
+
+// Приоритет операторов (общий для Parcer и разбора на этапе компиляции).
+// '^' связывает сильнее унарного минуса: -2^2 = -(2^2), 2^-1 = 2^(-1)
+constexpr int operatorPrecedence(char op) {
+    switch (op) {
+    case '+': case '-': return 1;
+    case '*': case '/': return 2;
+    case '~': return 3;
+    case '^': return 4;
+    default: return -1;
+    }
+}
+
+// 2^3^2 = 2^(3^2)
+constexpr bool isRightAssociativeOperator(char op) {
+    return op == '~' || op == '^';
+}
\ No newline at end of file
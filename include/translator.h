@@ -1,25 +1,106 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include "lexer.h"
 #include "parser.h"
 #include "token.h"
 #include "stack.h"
+#include "evaluation_limits.h"
+#include "program.h"
+#include "optimizer.h"
+#include "register_vm.h"
+#include "threaded.h"
+#include "program_file.h"
 
 // Вычисление выражений в RPN
 class Eval {
+    // Стек значений переиспользуется между вызовами
+    ds::Stack<double> valueStack;
+    std::size_t scratchLimit{ kDefaultScratchLimit };
+    std::size_t maxStackDepth{ EvaluationLimits::kUnlimited };
+
+    // Строк в блоке столбцового вычисления: стек блоков помещается в L1/L2
+    static constexpr std::size_t kBatchBlock = 256;
+    std::vector<double> batchScratch;            // stackDepth блоков подряд
+    std::vector<const double*> batchOperands;    // Текущие операнды: свой блок или входной столбец
+
+    double* batchBlock(std::size_t position) { return batchScratch.data() + position * kBatchBlock; }
+
 public:
-    double evaluateRpn(const std::vector<Token>& rpnTokens) const {
-        ds::Stack<double> valueStack;
+    static constexpr std::size_t kDefaultScratchLimit = 4096;
+
+    // Максимальная емкость стека (в значениях), которая сохраняется между вызовами
+    void setScratchLimit(std::size_t maxValues) { scratchLimit = maxValues; }
+    std::size_t getScratchLimit() const noexcept { return scratchLimit; }
+
+    // Наибольшая глубина стека значений (EvaluationLimits::maxStackDepth)
+    void setStackLimit(std::size_t maxValues) { maxStackDepth = maxValues; }
+    std::size_t getStackLimit() const noexcept { return maxStackDepth; }
+
+    // Бинарный оператор RPN; rightIsLiteral - правый операнд записан числом прямо перед оператором
+    static double applyOperator(char operatorChar, double leftOperand, double rightOperand, bool rightIsLiteral) {
+        switch (operatorChar) {
+        case '+': return leftOperand + rightOperand;
+        case '-': return leftOperand - rightOperand;
+        case '*': return leftOperand * rightOperand;
+        case '/':
+            // Делитель-литерал - степень двойки: умножение на точную обратную величину
+            if (rightIsLiteral && hasExactReciprocal(rightOperand)) return leftOperand * (1.0 / rightOperand);
+            if (rightOperand == 0.0) throw std::runtime_error("Eval error: division by zero");
+            return leftOperand / rightOperand;
+        case '^':
+            // Небольшой целый показатель-литерал - умножениями, как PowerInt в скомпилированной программе
+            if (rightIsLiteral && isSmallIntegerExponent(rightOperand)) return integerPower(leftOperand, static_cast<int>(rightOperand));
+            return applyMathFunction(MathFunction::Pow, leftOperand, rightOperand);
+        default:
+            throw std::runtime_error("Eval error: unknown operator");
+        }
+    }
+
+    double evaluateRpn(const std::vector<Token>& rpnTokens) {
+        return evaluateRange(rpnTokens.data(), rpnTokens.data() + rpnTokens.size());
+    }
+
+    // Вычисление отрезка RPN [first, last), который сам является законченным выражением
+    double evaluateRange(const Token* first, const Token* last) {
+        valueStack.clear();
+        if (valueStack.capacity() > scratchLimit) valueStack.shrink_to_fit();
+
+        const Token* previousToken = nullptr;
+        for (const Token* current = first; current != last; ++current) {
+            const Token& token = *current;
+            // Правый операнд - литерал, если он непосредственно предшествует оператору
+            const bool rightIsLiteral = previousToken && previousToken->type == TokenType::Number;
+            previousToken = &token;
 
-        for (const Token& token : rpnTokens) {
             // Если число - кладем в стек
             if (token.type == TokenType::Number) {
+                if (valueStack.size() >= maxStackDepth) throw LimitExceeded(LimitKind::StackDepth, maxStackDepth);
                 valueStack.push(token.numericValue);
                 continue;
             }
 
+            // Значения переменных передаются только скомпилированной программе
+            if (token.type == TokenType::Identifier) {
+                throw std::runtime_error("Eval error: unbound variable '" + token.content + "'");
+            }
+
+            // Вызов функции: аргументы сняты со стека в обратном порядке
+            if (token.type == TokenType::Function) {
+                const MathFunctionInfo* function = findMathFunction(token.content);
+                if (!function) throw std::runtime_error("Eval error: unknown function");
+                if (valueStack.size() < function->arity) throw std::runtime_error("Eval error: function needs more operands");
+                double secondArgument = 0.0;
+                if (function->arity == 2) {
+                    secondArgument = valueStack.top();
+                    valueStack.pop();
+                }
+                valueStack.top() = applyMathFunction(function->id, valueStack.top(), secondArgument);
+                continue;
+            }
+
             if (token.type != TokenType::Operator) {
                 throw std::runtime_error("Eval error: unexpected token in RPN");
             }
@@ -45,37 +126,274 @@ public:
             valueStack.pop();
 
             // Выполняем операцию и кладем результат в стек
-            switch (operatorChar) {
-            case '+': valueStack.push(leftOperand + rightOperand); break;
-            case '-': valueStack.push(leftOperand - rightOperand); break;
-            case '*': valueStack.push(leftOperand * rightOperand); break;
-            case '/':
-                if (rightOperand == 0.0) throw std::runtime_error("Eval error: division by zero");
-                valueStack.push(leftOperand / rightOperand);
+            valueStack.push(applyOperator(operatorChar, leftOperand, rightOperand, rightIsLiteral));
+        }
+
+        // В стеке должно остаться одно значение - результат
+        if (valueStack.size() != 1) throw std::runtime_error("Eval error: invalid expression");
+        return valueStack.top();
+    }
+
+    // Вычисление байткода; variables - значения слотов program.variables.
+    // CompiledProgram - Program или ProgramView из файла: нужны code, constants и stackDepth
+    template <typename CompiledProgram>
+    double evaluateProgram(const CompiledProgram& program, const double* variables) {
+        valueStack.clear();
+        if (valueStack.capacity() > scratchLimit) valueStack.shrink_to_fit();
+        // Глубина известна заранее, поэтому стек больше не растет во время вычисления
+        if (program.stackDepth > maxStackDepth) throw LimitExceeded(LimitKind::StackDepth, maxStackDepth);
+        valueStack.reserve(program.stackDepth);
+
+        for (const Instruction& instruction : program.code) {
+            switch (instruction.opCode) {
+            case OpCode::PushConstant:
+                valueStack.push(program.constants[instruction.operand]);
+                break;
+            case OpCode::PushVariable:
+                valueStack.push(variables[instruction.operand]);
+                break;
+            case OpCode::Negate:
+                valueStack.top() = -valueStack.top();
+                break;
+            case OpCode::PowerInt:
+                valueStack.top() = integerPower(valueStack.top(), powerIntExponent(instruction));
+                break;
+            case OpCode::DivideConstant:
+                valueStack.top() = valueStack.top() / program.constants[instruction.operand];
                 break;
-            default:
-                throw std::runtime_error("Eval error: unknown operator");
+            case OpCode::Call: {
+                MathFunction function = static_cast<MathFunction>(instruction.operand);
+                double secondArgument = 0.0;
+                if (mathFunctionInfo(function).arity == 2) {
+                    secondArgument = valueStack.top();
+                    valueStack.pop();
+                }
+                valueStack.top() = applyMathFunction(function, valueStack.top(), secondArgument);
+                break;
+            }
+            default: {
+                double rightOperand = valueStack.top();
+                valueStack.pop();
+                double& leftOperand = valueStack.top();
+                switch (instruction.opCode) {
+                case OpCode::Add: leftOperand = leftOperand + rightOperand; break;
+                case OpCode::Subtract: leftOperand = leftOperand - rightOperand; break;
+                case OpCode::Multiply: leftOperand = leftOperand * rightOperand; break;
+                case OpCode::Divide:
+                    if (rightOperand == 0.0) throw std::runtime_error("Eval error: division by zero");
+                    leftOperand = leftOperand / rightOperand;
+                    break;
+                case OpCode::Power:
+                    leftOperand = applyMathFunction(MathFunction::Pow, leftOperand, rightOperand);
+                    break;
+                default:
+                    throw std::runtime_error("Eval error: unknown instruction");
+                }
+                break;
+            }
             }
         }
 
-        // В стеке должно остаться одно значение - результат
         if (valueStack.size() != 1) throw std::runtime_error("Eval error: invalid expression");
         return valueStack.top();
     }
+
+    // Столбцовое вычисление: columns[slot] - значения переменной для rowCount строк.
+    // Каждая инструкция выполняется циклом по блоку строк, который компилятор векторизует
+    void evaluateBatch(const Program& program, const double* const* columns, std::size_t rowCount, double* results) {
+        const std::size_t depth = program.stackDepth;
+        if (depth > maxStackDepth) throw LimitExceeded(LimitKind::StackDepth, maxStackDepth);
+        // Лишний блок - временный буфер для PowerInt
+        batchScratch.resize((depth + 1) * kBatchBlock);
+        batchOperands.resize(depth);
+
+        for (std::size_t blockStart = 0; blockStart < rowCount; blockStart += kBatchBlock) {
+            const std::size_t count = std::min(kBatchBlock, rowCount - blockStart);
+            std::size_t top = 0;   // Число значений на стеке блоков
+
+            for (const Instruction& instruction : program.code) {
+                switch (instruction.opCode) {
+                case OpCode::PushConstant: {
+                    double* target = batchBlock(top);
+                    const double constant = program.constants[instruction.operand];
+                    for (std::size_t i = 0; i < count; ++i) target[i] = constant;
+                    batchOperands[top++] = target;
+                    break;
+                }
+                case OpCode::PushVariable:
+                    // Столбец используется напрямую, без копирования
+                    batchOperands[top++] = columns[instruction.operand] + blockStart;
+                    break;
+                case OpCode::Negate: {
+                    const double* operand = batchOperands[top - 1];
+                    double* target = batchBlock(top - 1);
+                    for (std::size_t i = 0; i < count; ++i) target[i] = -operand[i];
+                    batchOperands[top - 1] = target;
+                    break;
+                }
+                case OpCode::PowerInt: {
+                    double* target = batchBlock(top - 1);
+                    integerPower(batchOperands[top - 1], powerIntExponent(instruction), target, batchBlock(depth), count);
+                    batchOperands[top - 1] = target;
+                    break;
+                }
+                case OpCode::DivideConstant: {
+                    const double* operand = batchOperands[top - 1];
+                    double* target = batchBlock(top - 1);
+                    const double divisor = program.constants[instruction.operand];
+                    for (std::size_t i = 0; i < count; ++i) target[i] = operand[i] / divisor;
+                    batchOperands[top - 1] = target;
+                    break;
+                }
+                case OpCode::Call: {
+                    MathFunction function = static_cast<MathFunction>(instruction.operand);
+                    std::size_t arity = mathFunctionInfo(function).arity;
+                    const double* first = batchOperands[top - arity];
+                    const double* second = arity == 2 ? batchOperands[top - 1] : first;
+                    double* target = batchBlock(top - arity);
+                    applyMathFunction(function, first, second, target, count);
+                    top -= arity - 1;
+                    batchOperands[top - 1] = target;
+                    break;
+                }
+                default: {
+                    const double* left = batchOperands[top - 2];
+                    const double* right = batchOperands[top - 1];
+                    double* target = batchBlock(top - 2);
+                    switch (instruction.opCode) {
+                    case OpCode::Add:
+                        for (std::size_t i = 0; i < count; ++i) target[i] = left[i] + right[i];
+                        break;
+                    case OpCode::Subtract:
+                        for (std::size_t i = 0; i < count; ++i) target[i] = left[i] - right[i];
+                        break;
+                    case OpCode::Multiply:
+                        for (std::size_t i = 0; i < count; ++i) target[i] = left[i] * right[i];
+                        break;
+                    case OpCode::Divide: {
+                        bool zeroDivisor = false;
+                        for (std::size_t i = 0; i < count; ++i) zeroDivisor |= right[i] == 0.0;
+                        if (zeroDivisor) throw std::runtime_error("Eval error: division by zero");
+                        for (std::size_t i = 0; i < count; ++i) target[i] = left[i] / right[i];
+                        break;
+                    }
+                    case OpCode::Power:
+                        applyMathFunction(MathFunction::Pow, left, right, target, count);
+                        break;
+                    default:
+                        throw std::runtime_error("Eval error: unknown instruction");
+                    }
+                    top--;
+                    batchOperands[top - 1] = target;
+                    break;
+                }
+                }
+            }
+
+            if (top != 1) throw std::runtime_error("Eval error: invalid expression");
+            std::copy(batchOperands[0], batchOperands[0] + count, results + blockStart);
+        }
+    }
+};
+
+// Значение или текст ошибки одного выражения (пакетное и асинхронное вычисление)
+struct EvaluationResult {
+    double value{ 0.0 };
+    std::string error;   // Пусто, если вычисление успешно
+    bool ok() const noexcept { return error.empty(); }
 };
 
 class Translator {
     Lexer tokenizer;
     Parcer converter;
     Eval evaluator;
+    RegisterVM registerMachine;
+    ThreadedEval threadedEvaluator;
+
+    // Длина проверяется до копирования выражения в лексер: отвергнутый запрос не стоит копии
+    void loadInput(const std::string& expression) {
+        const std::size_t maxInputBytes = converter.getLimits().maxInputBytes;
+        if (expression.size() > maxInputBytes) throw LimitExceeded(LimitKind::InputBytes, maxInputBytes);
+        tokenizer.setInput(expression);
+    }
 
 public:
+    // Порог, выше которого рабочие буферы освобождаются после патологического ввода
+    void setScratchLimit(std::size_t maxElements) {
+        converter.setScratchLimit(maxElements);
+        evaluator.setScratchLimit(maxElements);
+    }
+
+    // Лимиты для недоверенного ввода; превышение бросает LimitExceeded со своим кодом
+    void setLimits(const EvaluationLimits& limits) {
+        converter.setLimits(limits);
+        evaluator.setStackLimit(limits.maxStackDepth);
+    }
+
     double calculate(const std::string& expression) {
         // Шаг 1: Лексический анализ - разбиваем строку на токены
-        tokenizer.setInput(expression);
-        // Шаг 2: Преобразуем в обратную польскую нотацию
-        std::vector<Token> rpnSequence = converter.toRpn(tokenizer);
+        loadInput(expression);
+        // Шаг 2: Преобразуем в обратную польскую нотацию (буфер парсера, без копирования)
+        const std::vector<Token>& rpnSequence = converter.toRpn(tokenizer);
         // Шаг 3: Вычисляем значение RPN выражения
         return evaluator.evaluateRpn(rpnSequence);
     }
+
+    // Разбор один раз: переменные получают слоты, значения передаются при вычислении
+    Program compile(const std::string& expression) {
+        loadInput(expression);
+        return Compiler::compile(converter.toRpn(tokenizer));
+    }
+
+    // Компиляция с оптимизациями (см. OptimizerOptions)
+    Program compile(const std::string& expression, const OptimizerOptions& options) {
+        return Optimizer::optimize(compile(expression), options);
+    }
+
+    // Та же программа для регистровой машины (результаты совпадают со стековой бит в бит)
+    RegisterProgram compileRegisters(const std::string& expression, const OptimizerOptions& options = {}) {
+        return RegisterCompiler::compile(compile(expression, options));
+    }
+
+    // Шитый код с суперинструкциями для стековой машины
+    ThreadedProgram compileThreaded(const std::string& expression, const OptimizerOptions& options = {}) {
+        return ThreadedEval::compile(compile(expression, options));
+    }
+
+    double calculate(const Program& program, const std::vector<double>& variables = {}) {
+        if (variables.size() < program.variables.size()) {
+            throw std::runtime_error("Eval error: missing variable values");
+        }
+        return evaluator.evaluateProgram(program, variables.data());
+    }
+
+    // Программа из библиотеки ProgramLibrary, без копирования
+    double calculate(const ProgramView& program, const std::vector<double>& variables = {}) {
+        if (variables.size() < program.variableCount()) {
+            throw std::runtime_error("Eval error: missing variable values");
+        }
+        return evaluator.evaluateProgram(program, variables.data());
+    }
+
+    double calculate(const RegisterProgram& program, const std::vector<double>& variables = {}) {
+        if (variables.size() < program.variables.size()) {
+            throw std::runtime_error("Eval error: missing variable values");
+        }
+        return registerMachine.evaluate(program, variables.data());
+    }
+
+    double calculate(const ThreadedProgram& program, const std::vector<double>& variables = {}) {
+        if (variables.size() < program.variables.size()) {
+            throw std::runtime_error("Eval error: missing variable values");
+        }
+        return threadedEvaluator.evaluate(program, variables.data());
+    }
+
+    // Вычисление для многих строк сразу: columns[slot] указывает на rowCount значений переменной
+    void calculateBatch(const Program& program, const std::vector<const double*>& columns, std::size_t rowCount, double* results) {
+        if (columns.size() < program.variables.size()) {
+            throw std::runtime_error("Eval error: missing variable values");
+        }
+        evaluator.evaluateBatch(program, columns.data(), rowCount, results);
+    }
 };
\ No newline at end of file
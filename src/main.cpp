@@ -1,10 +1,157 @@
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <stdexcept>
+#include <csignal>
 
 #include "translator.h"
+#include "batch.h"
+#include "number_format.h"
+#include "server.h"
+#include "shm_ring.h"
 
-int main() {
+// translator_app --file <путь или -> [--fixed <знаков> | --precision <цифр>]
+// По результату на каждую строку, одинаковые строки вычисляются один раз. Числа по умолчанию -
+// кратчайшая запись, которая читается обратно в то же значение. Статистика повторов - в stderr
+static int runBatch(int argc, char** argv) {
+    std::string path;
+    NumberFormatOptions format;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << argument << "\n";
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (argument == "--file") path = value;
+        else if (argument == "--fixed") format = { NumberFormat::Fixed, std::stoi(value) };
+        else if (argument == "--precision") format = { NumberFormat::Precision, std::stoi(value) };
+        else {
+            std::cerr << "Unknown option " << argument << "\n";
+            return 2;
+        }
+    }
+
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cerr << "Cannot open " << path << "\n";
+            return 1;
+        }
+    }
+    std::istream& input = path == "-" ? std::cin : file;
+    std::ios::sync_with_stdio(false);
+
+    BatchEvaluator batch;
+    OutputBuffer output(stdout);
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const EvaluationResult& result = batch.evaluate(line);
+        if (result.ok()) {
+            output.appendNumber(result.value, format);
+        }
+        else {
+            output.append("Error: ");
+            output.append(result.error);
+        }
+        output.append('\n');
+    }
+    output.flush();
+
+    const BatchStats& stats = batch.stats();
+    std::cerr << "Lines: " << stats.lines << ", distinct: " << stats.distinct
+              << ", dedup ratio: " << stats.dedupRatio() << "\n";
+    return 0;
+}
+
+#if defined(__linux__)
+// Сервер, который останавливается по SIGINT/SIGTERM
+static EvaluationServer* runningServer = nullptr;
+static ShmEvaluationServer* runningShmServer = nullptr;
+
+static void stopServer(int) {
+    if (runningServer) runningServer->stop();
+    if (runningShmServer) runningShmServer->stop();
+}
+
+// translator_app --serve <путь сокета> [--tcp <порт>] [--workers <n>] [--batch <n>]
+//                [--max-bytes <n>] [--max-tokens <n>] [--max-depth <n>] [--max-stack <n>]
+// translator_app --shm <имя объекта shm> [--slots <n>]
+static int serve(int argc, char** argv) {
+    ServerOptions options;
+    std::string shmName;
+    std::uint32_t shmSlots = 4;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << argument << "\n";
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (argument == "--serve") options.unixPath = value;
+        else if (argument == "--tcp") options.tcpPort = static_cast<std::uint16_t>(std::stoul(value));
+        else if (argument == "--workers") options.workerCount = std::stoul(value);
+        else if (argument == "--batch") options.maxBatch = std::stoul(value);
+        else if (argument == "--max-bytes") options.limits.maxInputBytes = std::stoul(value);
+        else if (argument == "--max-tokens") options.limits.maxTokens = std::stoul(value);
+        else if (argument == "--max-depth") options.limits.maxNesting = std::stoul(value);
+        else if (argument == "--max-stack") options.limits.maxStackDepth = std::stoul(value);
+        else if (argument == "--shm") shmName = value;
+        else if (argument == "--slots") shmSlots = static_cast<std::uint32_t>(std::stoul(value));
+        else {
+            std::cerr << "Unknown option " << argument << "\n";
+            return 2;
+        }
+    }
+
+    if (!shmName.empty()) {
+        ShmEvaluationServer server(shmName, shmSlots);
+        runningShmServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        std::cerr << "Serving shared memory " << shmName << " with " << shmSlots << " client slots\n";
+        server.start();
+        server.wait();
+        runningShmServer = nullptr;
+        return 0;
+    }
+
+    EvaluationServer server(options);
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    std::cerr << "Serving on " << (options.unixPath.empty() ? "" : options.unixPath)
+              << (options.tcpPort ? " 127.0.0.1:" + std::to_string(options.tcpPort) : "")
+              << " with " << options.workerCount << " workers\n";
+    server.run();
+    runningServer = nullptr;
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--file") {
+        try {
+            return runBatch(argc, argv);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+#if defined(__linux__)
+    if (argc > 1) {
+        try {
+            return serve(argc, argv);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+#endif
     Translator calculator;
 
     std::cout << "Enter expression per line. Empty line or EOF to exit.\n";
@@ -24,7 +171,7 @@ int main() {
         // Вычисляем выражение и обрабатываем ошибки
         try {
             double computationResult = calculator.calculate(inputLine);
-            std::cout << computationResult << "\n";
+            std::cout << formatNumber(computationResult) << "\n";
         }
         catch (const std::exception& e) {
             std::cout << "Error: " << e.what() << "\n";
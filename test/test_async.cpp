@@ -0,0 +1,106 @@
+#include <gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async.h"
+
+TEST(AsyncTranslatorTest, GetReturnsValueAndRethrowsErrors) {
+    AsyncTranslator async(2);
+    EXPECT_DOUBLE_EQ(async.calculateAsync("2*(3+4)-5/2").get(), 11.5);
+    EXPECT_THROW(async.calculateAsync("1/0").get(), std::runtime_error);
+    EXPECT_THROW(async.calculateAsync("2+").get(), std::runtime_error);
+}
+
+static Task<double> sumOfTwo(AsyncTranslator& async, std::string left, std::string right) {
+    double first = co_await async.calculateAsync(std::move(left));
+    double second = co_await async.calculateAsync(std::move(right));
+    co_return first + second;
+}
+
+static Task<double> chain(AsyncTranslator& async, int steps) {
+    double total = 0.0;
+    for (int i = 0; i < steps; ++i) {
+        total += co_await async.calculateAsync(std::to_string(i) + "*2");
+    }
+    total += co_await sumOfTwo(async, "1", "2");
+    co_return total;
+}
+
+TEST(AsyncTranslatorTest, CoroutinesAwaitEvaluations) {
+    AsyncTranslator async(2);
+    EXPECT_DOUBLE_EQ(syncWait(sumOfTwo(async, "sqrt(16)", "2^10")), 1028.0);
+    // Сумма 2*i для i < 100 плюс 3
+    EXPECT_DOUBLE_EQ(syncWait(chain(async, 100)), 9903.0);
+}
+
+static Task<void> awaitFailure(AsyncTranslator& async, std::string& caught) {
+    try {
+        co_await async.calculateAsync("unknown(1)");
+    }
+    catch (const std::runtime_error& e) {
+        caught = e.what();
+    }
+    co_await async.calculateAsync("1/0");
+}
+
+TEST(AsyncTranslatorTest, ErrorsPropagateThroughCoroutines) {
+    AsyncTranslator async(1);
+    std::string caught;
+    EXPECT_THROW(syncWait(awaitFailure(async, caught)), std::runtime_error);
+    EXPECT_FALSE(caught.empty());
+}
+
+TEST(AsyncTranslatorTest, CancelledBeforeStartIsNotEvaluated) {
+    AsyncTranslator async(1);
+    CancellationSource source;
+    source.cancel();
+    EXPECT_THROW(async.calculateAsync("1+1", source.token()).get(), OperationCancelled);
+
+    std::vector<EvaluationResult> results = async.calculateAllAsync({ "1", "2", "3" }, source.token()).get();
+    ASSERT_EQ(results.size(), 3u);
+    for (const EvaluationResult& result : results) {
+        EXPECT_FALSE(result.ok());
+        EXPECT_EQ(result.error, "Async error: cancelled");
+    }
+
+    // Токен по умолчанию не отменяется никогда
+    EXPECT_DOUBLE_EQ(async.calculateAsync("1+1", CancellationToken()).get(), 2.0);
+}
+
+TEST(AsyncTranslatorTest, BulkKeepsOrderAndPerItemErrors) {
+    AsyncTranslator async(3);
+    std::vector<std::string> expressions;
+    for (int i = 0; i < 1000; ++i) {
+        expressions.push_back(i % 97 == 0 ? "1/0" : std::to_string(i) + "+0.5");
+    }
+    std::vector<EvaluationResult> results = async.calculateAllAsync(expressions).get();
+    ASSERT_EQ(results.size(), expressions.size());
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 97 == 0) {
+            EXPECT_FALSE(results[i].ok());
+        }
+        else {
+            ASSERT_TRUE(results[i].ok()) << results[i].error;
+            EXPECT_DOUBLE_EQ(results[i].value, i + 0.5);
+        }
+    }
+    EXPECT_TRUE(async.calculateAllAsync({}).get().empty());
+}
+
+TEST(AsyncTranslatorTest, ManyInFlightShareFewThreads) {
+    AsyncTranslator async(2);
+    std::vector<std::thread> submitters;
+    std::vector<std::vector<AsyncTask<double>>> perSubmitter(4);
+    for (int t = 0; t < 4; ++t) {
+        submitters.emplace_back([&, t] {
+            for (int i = 0; i < 2000; ++i) perSubmitter[t].push_back(async.calculateAsync(std::to_string(t) + "*1000+" + std::to_string(i)));
+        });
+    }
+    for (std::thread& submitter : submitters) submitter.join();
+    for (int t = 0; t < 4; ++t) {
+        for (int i = 0; i < 2000; ++i) ASSERT_DOUBLE_EQ(perSubmitter[t][i].get(), t * 1000.0 + i);
+    }
+    EXPECT_EQ(async.threadCount(), 2u);
+}
@@ -0,0 +1,39 @@
+#include <gtest.h>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+
+TEST(BatchEvaluatorTest, DuplicatesShareResultsInOrder) {
+    const std::vector<std::string> lines = { "1+2", "2*(3+4)", "1+2", "1/0", "", "2*(3+4)", "1/0", "1+2", "1 + 2" };
+    BatchEvaluator batch;
+    Translator translator;
+    for (const std::string& line : lines) {
+        const EvaluationResult& result = batch.evaluate(line);
+        try {
+            const double expected = translator.calculate(line);
+            ASSERT_TRUE(result.ok()) << line;
+            EXPECT_EQ(result.value, expected) << line;
+        }
+        catch (const std::exception& e) {
+            EXPECT_EQ(result.error, e.what()) << line;
+        }
+    }
+    // "1 + 2" - другая строка, хотя значение то же
+    EXPECT_EQ(batch.stats().lines, lines.size());
+    EXPECT_EQ(batch.stats().distinct, 5u);
+    EXPECT_DOUBLE_EQ(batch.stats().dedupRatio(), 9.0 / 5.0);
+
+    batch.clear();
+    EXPECT_EQ(batch.stats().lines, 0u);
+    EXPECT_DOUBLE_EQ(batch.stats().dedupRatio(), 1.0);
+}
+
+TEST(BatchEvaluatorTest, HeavyDuplicationEvaluatesOnce) {
+    BatchEvaluator batch;
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_DOUBLE_EQ(batch.evaluate(i % 2 ? "sqrt(16)+2^10" : "max(3, 7)").value, i % 2 ? 1028.0 : 7.0);
+    }
+    EXPECT_EQ(batch.stats().distinct, 2u);
+    EXPECT_DOUBLE_EQ(batch.stats().dedupRatio(), 5000.0);
+}
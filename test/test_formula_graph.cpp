@@ -0,0 +1,99 @@
+#include <gtest.h>
+#include <stdexcept>
+#include <string>
+#include <atomic>
+#include <vector>
+
+#include "formula_graph.h"
+#include "thread_pool.h"
+
+TEST(FormulaGraphTest, DependentFormulas) {
+    FormulaGraph graph;
+    graph.define("ratio = margin / revenue");
+    graph.define("margin = revenue - cost");
+    graph.setInput("revenue", 200.0);
+    graph.setInput("cost", 150.0);
+    graph.evaluate();
+    EXPECT_DOUBLE_EQ(graph.value("margin"), 50.0);
+    EXPECT_DOUBLE_EQ(graph.value("ratio"), 0.25);
+    EXPECT_EQ(graph.levelCount(), 2u);
+
+    graph.setInput("cost", 100.0);
+    graph.evaluate();
+    EXPECT_DOUBLE_EQ(graph.value("ratio"), 0.5);
+}
+
+TEST(FormulaGraphTest, CyclesAreRejected) {
+    FormulaGraph graph;
+    graph.define("a = b + 1");
+    graph.define("b = c * 2");
+    graph.define("c = a - 3");
+    EXPECT_THROW(graph.evaluate(), std::runtime_error);
+
+    graph.define("c = 4");
+    graph.evaluate();
+    EXPECT_DOUBLE_EQ(graph.value("a"), 9.0);
+
+    FormulaGraph selfReference;
+    selfReference.define("x = x + 1");
+    EXPECT_THROW(selfReference.evaluate(), std::runtime_error);
+}
+
+TEST(FormulaGraphTest, ErrorsPropagateDownstream) {
+    FormulaGraph graph;
+    graph.define("share = part / total");
+    graph.define("percent = share * 100");
+    graph.define("other = part + 1");
+    graph.setInput("part", 3.0);
+    graph.setInput("total", 0.0);
+    graph.evaluate();
+    EXPECT_THROW(graph.value("share"), std::runtime_error);
+    EXPECT_THROW(graph.value("percent"), std::runtime_error);
+    EXPECT_DOUBLE_EQ(graph.value("other"), 4.0);
+
+    EXPECT_THROW(graph.define("1bad = 2"), std::runtime_error);
+    EXPECT_THROW(graph.define("no separator"), std::runtime_error);
+    EXPECT_THROW(graph.setInput("share", 1.0), std::runtime_error);
+    EXPECT_THROW(graph.value("missing"), std::runtime_error);
+}
+
+TEST(FormulaGraphTest, ParallelMatchesSequential) {
+    // Несколько широких уровней: каждая формула зависит от двух формул предыдущего уровня
+    const int width = 2000, depth = 6;
+    FormulaGraph sequential, parallel;
+    for (int level = 0; level < depth; ++level) {
+        for (int i = 0; i < width; ++i) {
+            std::string name = "f" + std::to_string(level) + "_" + std::to_string(i);
+            std::string expression = level == 0
+                ? "x * " + std::to_string(i % 17) + " + 1"
+                : "f" + std::to_string(level - 1) + "_" + std::to_string(i) + " / 3 - f"
+                    + std::to_string(level - 1) + "_" + std::to_string((i + 1) % width);
+            sequential.define(name, expression);
+            parallel.define(name, expression);
+        }
+    }
+    sequential.setInput("x", 1.5);
+    parallel.setInput("x", 1.5);
+
+    ThreadPool pool(4);
+    sequential.evaluate();
+    parallel.evaluate(pool);
+    EXPECT_EQ(parallel.levelCount(), static_cast<std::size_t>(depth));
+    for (int i = 0; i < width; i += 97) {
+        std::string name = "f" + std::to_string(depth - 1) + "_" + std::to_string(i);
+        EXPECT_EQ(parallel.value(name), sequential.value(name)) << name;
+    }
+}
+
+TEST(ThreadPoolTest, ParallelForCoversRangeAndRethrows) {
+    ThreadPool pool(3);
+    std::vector<std::atomic<int>> visits(10000);
+    pool.parallelFor(visits.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) visits[i]++;
+    });
+    for (const auto& count : visits) EXPECT_EQ(count.load(), 1);
+
+    EXPECT_THROW(pool.parallelFor(100, [](std::size_t begin, std::size_t) {
+        if (begin == 0) throw std::runtime_error("boom");
+    }), std::runtime_error);
+}
@@ -0,0 +1,54 @@
+#include <gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "incremental.h"
+#include "translator.h"
+
+TEST(IncrementalEvalTest, MatchesFullEvaluation) {
+    Translator calc;
+    Program program = calc.compile("(a + b) * (c - d) / (e + 1) - -(a * f) + g / 4 + max(a, g) - sqrt(abs(b))");
+    ASSERT_EQ(program.variables.size(), 7u);
+
+    std::vector<double> values(program.variables.size(), 1.0);
+    IncrementalEval incremental(program);
+    for (std::size_t slot = 0; slot < values.size(); ++slot) incremental.setVariable(slot, values[slot]);
+    EXPECT_EQ(incremental.value(), calc.calculate(program, values));
+
+    for (int step = 0; step < 50; ++step) {
+        std::size_t slot = static_cast<std::size_t>(step * 5 % 7);
+        values[slot] = step * 0.37 - 4.0;
+        incremental.setVariable(slot, values[slot]);
+        EXPECT_EQ(incremental.value(), calc.calculate(program, values)) << step;
+    }
+}
+
+TEST(IncrementalEvalTest, RecomputesOnlyAffectedPath) {
+    // Цепочка из 64 слагаемых: изменение последнего затрагивает только лист и корень
+    std::string expression = "x0";
+    for (int i = 1; i < 64; ++i) expression += "+x" + std::to_string(i);
+    Translator calc;
+    IncrementalEval incremental(calc.compile(expression));
+    EXPECT_DOUBLE_EQ(incremental.value(), 0.0);
+    EXPECT_EQ(incremental.lastRecomputedCount(), 127u);
+
+    incremental.setVariable("x63", 5.0);
+    EXPECT_DOUBLE_EQ(incremental.value(), 5.0);
+    EXPECT_EQ(incremental.lastRecomputedCount(), 2u);
+
+    incremental.setVariable("x63", 5.0);
+    EXPECT_DOUBLE_EQ(incremental.value(), 5.0);
+    EXPECT_EQ(incremental.lastRecomputedCount(), 0u);
+}
+
+TEST(IncrementalEvalTest, DivisionByZeroRecovers) {
+    Translator calc;
+    IncrementalEval incremental(calc.compile("1 / x + y"));
+    EXPECT_THROW(incremental.value(), std::runtime_error);
+    incremental.setVariable("x", 4.0);
+    EXPECT_DOUBLE_EQ(incremental.value(), 0.25);
+    incremental.setVariable("y", 1.0);
+    EXPECT_DOUBLE_EQ(incremental.value(), 1.25);
+    EXPECT_THROW(incremental.setVariable("z", 1.0), std::out_of_range);
+}
@@ -0,0 +1,46 @@
+#include <gtest.h>
+#include <stdexcept>
+#include <string>
+
+#include "kernel.h"
+#include "translator.h"
+
+using Polynomial = Kernel<"3*x*x*x + 2*x*x - 5*x + 7">;
+using Ratio = Kernel<"(a + b) * (a - b) / (c + 1)">;
+
+static_assert(Polynomial::arity == 1);
+static_assert(Polynomial{}(2.0) == 29.0);
+static_assert(Ratio::arity == 3);
+static_assert(Ratio::variableName(0) == "a" && Ratio::variableName(2) == "c");
+static_assert(Kernel<"-(2+3)*4">{}() == -20.0);
+static_assert(Kernel<"x^3 - 2^-2">{}(3.0) == 26.75);
+
+TEST(KernelTest, MatchesTranslatorWithSubstitutedValues) {
+    Translator calc;
+    for (double x : { -3.0, -0.5, 0.0, 1.25, 10.0 }) {
+        std::string text = "3*(" + std::to_string(x) + ")*(" + std::to_string(x) + ")*(" + std::to_string(x) + ") + 2*("
+            + std::to_string(x) + ")*(" + std::to_string(x) + ") - 5*(" + std::to_string(x) + ") + 7";
+        EXPECT_DOUBLE_EQ(Polynomial{}(x), calc.calculate(text)) << x;
+    }
+}
+
+TEST(KernelTest, SlotOrderAndRepeatedVariables) {
+    Ratio ratio;
+    const double values[] = { 5.0, 3.0, 1.0 };
+    EXPECT_DOUBLE_EQ(ratio(values), 8.0);
+    EXPECT_DOUBLE_EQ(ratio(5, 3, 1), 8.0);
+    EXPECT_DOUBLE_EQ((Kernel<"x/y - y/x">{}(2.0, 4.0)), 0.5 - 2.0);
+}
+
+TEST(KernelTest, PowerMatchesTranslator) {
+    Translator calc;
+    Program program = calc.compile("x^7 - 2^x + x^-2");
+    for (double x : { 0.5, 1.1, 3.0 }) {
+        EXPECT_EQ((Kernel<"x^7 - 2^x + x^-2">{}(x)), calc.calculate(program, { x })) << x;
+    }
+}
+
+TEST(KernelTest, DivisionByZero) {
+    EXPECT_THROW((Kernel<"1 / (x - 2)">{}(2.0)), std::runtime_error);
+    EXPECT_DOUBLE_EQ((Kernel<"x / 4">{}(2.0)), 0.5);
+}
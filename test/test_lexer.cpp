@@ -0,0 +1,126 @@
+#include <gtest.h>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lexer.h"
+#include "reference_lexer.h"
+#include "parser.h"
+
+// Лента токенов или текст ошибки, на которой лексер остановился
+template <typename LexerType>
+static std::vector<std::string> tokenStream(const std::string& input) {
+    LexerType lexer;
+    lexer.setInput(input);
+    std::vector<std::string> stream;
+    try {
+        for (;;) {
+            Token token = lexer.getNextToken();
+            std::string entry = std::to_string(static_cast<int>(token.type)) + ":" + token.content;
+            if (token.type == TokenType::Number) {
+                std::uint64_t bits;
+                std::memcpy(&bits, &token.numericValue, sizeof(bits));
+                entry += ":" + std::to_string(bits);
+            }
+            stream.push_back(std::move(entry));
+            if (token.type == TokenType::End) break;
+        }
+    }
+    catch (const std::runtime_error& e) {
+        stream.push_back(std::string("error:") + e.what());
+    }
+    return stream;
+}
+
+static void expectSameTokens(const std::string& input) {
+    EXPECT_EQ(tokenStream<Lexer>(input), tokenStream<ReferenceLexer>(input)) << "input: \"" << input << "\"";
+}
+
+TEST(LexerTest, MatchesReferenceOnKnownCases) {
+    const char* cases[] = {
+        "", "   ", "2*(3+4)-5/2", "-x^2", "2^-1", "max(a, -b)", "f (1)", "sin(x)*cos (y)",
+        "1e5", "1E+5", "1e-5", "1e", "1e+", "2e-x", "1.", ".5", ".", "..5", "1.2.3", "1..2",
+        "007", "0.000", "0e0", "1e999", "1e-400", "4.9e-324", "123456789012345678901234567890",
+        "0x10", "0X1f", "0x", "0xg", "0x.8", "0x.", "0x1p3", "0x1P-2", "0x1p", "0x1p+", "0x1.8p1", "0x1e", "0xe+1",
+        "x1", "_a_b9", "e", "E5", "p2", "abc123def", "a.b", "3x", "3ex", "3e2x",
+        "1 # 2", "1\t+\n2\r", "x;", "\xd0\xb0", "1 + ?"
+    };
+    for (const char* input : cases) expectSameTokens(input);
+    expectSameTokens(std::string("1+\0 2", 5));
+}
+
+TEST(LexerTest, MatchesReferenceOnRandomInput) {
+    // Алфавит подобран так, чтобы часто получались числа на грани формата
+    const std::string alphabet = "0123456789..eExXpP+-*/^(),abfz_ \t#";
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+    std::uniform_int_distribution<std::size_t> length(0, 24);
+    for (int i = 0; i < 20000; ++i) {
+        std::string input;
+        for (std::size_t n = length(generator); n > 0; --n) input += alphabet[pick(generator)];
+        expectSameTokens(input);
+        if (HasFailure()) return;
+    }
+}
+
+TEST(LexerTest, CharacterClassesKeepPublicPredicates) {
+    for (int code = 0; code < 256; ++code) {
+        const char ch = static_cast<char>(code);
+        const bool letter = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+        EXPECT_EQ(Lexer::isWhitespace(ch), ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') << code;
+        EXPECT_EQ(Lexer::isValidOperator(ch), ch != '\0' && std::strchr("+-*/^", ch) != nullptr) << code;
+        EXPECT_EQ(Lexer::isIdentifierStart(ch), letter) << code;
+        EXPECT_EQ(Lexer::isIdentifierChar(ch), letter || (ch >= '0' && ch <= '9')) << code;
+    }
+}
+
+TEST(LexerTest, TokenizeAllFillsParallelArrays) {
+    Lexer lexer("max(x1, -2.5e1) ^ 3");
+    TokenBuffer tokens;
+    lexer.tokenizeAll(tokens);
+    const std::vector<TokenType> expectedTypes = {
+        TokenType::Function, TokenType::LeftParen, TokenType::Identifier, TokenType::Comma, TokenType::Operator,
+        TokenType::Number, TokenType::RightParen, TokenType::Operator, TokenType::Number, TokenType::End
+    };
+    ASSERT_EQ(tokens.types, expectedTypes);
+    EXPECT_TRUE(tokens.error.empty());
+    EXPECT_EQ(tokens.operators[4], '~');
+    EXPECT_EQ(tokens.operators[7], '^');
+    EXPECT_DOUBLE_EQ(tokens.values[5], 25.0);
+    EXPECT_EQ(lexer.input().substr(tokens.offsets[5], tokens.lengths[5]), "2.5e1");
+    EXPECT_EQ(lexer.input().substr(tokens.offsets[0], tokens.lengths[0]), "max");
+    EXPECT_EQ(tokens.offsets[9], lexer.input().size());
+
+    // Ошибка записывается, а буфер заканчивается End на ее месте
+    lexer.setInput("1 + 2 # 3");
+    lexer.tokenizeAll(tokens);
+    ASSERT_EQ(tokens.size(), 4u);
+    EXPECT_EQ(tokens.types.back(), TokenType::End);
+    EXPECT_EQ(tokens.offsets.back(), 6u);
+    EXPECT_EQ(tokens.error, "Lexer error: unexpected character '#'");
+}
+
+TEST(LexerTest, ParserReportsErrorsInSourceOrder) {
+    // Первой сообщается ошибка, которая стоит раньше в строке, будь то ошибка лексера или парсера
+    auto errorOf = [](const std::string& input) {
+        Lexer lexer(input);
+        Parcer parser;
+        try {
+            parser.toRpn(lexer);
+        }
+        catch (const std::runtime_error& e) {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    EXPECT_EQ(errorOf("1 2 #"), "Parser error: operator expected");
+    EXPECT_EQ(errorOf("1 + #"), "Lexer error: unexpected character '#'");
+    EXPECT_EQ(errorOf(") ."), "Parser error: operand expected");
+    EXPECT_EQ(errorOf("(1 + ."), "Lexer error: invalid number");
+    EXPECT_EQ(errorOf("(1 + 2"), "Parser error: '(' without matching ')'");
+    EXPECT_EQ(errorOf("foo(1) $"), "Parser error: unknown function 'foo'");
+    EXPECT_EQ(errorOf("1 +"), "Parser error: operand expected");
+    EXPECT_EQ(errorOf("2*(3+4)-5/2"), "");
+}
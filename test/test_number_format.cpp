@@ -0,0 +1,76 @@
+#include <gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "number_format.h"
+
+TEST(NumberFormatTest, ShortestRoundTripsExactly) {
+    std::mt19937_64 generator(17);
+    for (int i = 0; i < 200000; ++i) {
+        // Случайные биты покрывают все порядки, субнормальные числа и оба знака
+        std::uint64_t bits = generator();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (!std::isfinite(value)) continue;
+        const std::string text = formatNumber(value);
+        const double parsed = std::strtod(text.c_str(), nullptr);
+        ASSERT_EQ(std::memcmp(&parsed, &value, sizeof(value)), 0) << text;
+        // Не длиннее %.17g, которым пользовался сервер
+        char reference[64];
+        ASSERT_LE(text.size(), static_cast<std::size_t>(std::snprintf(reference, sizeof(reference), "%.17g", value))) << text;
+    }
+}
+
+TEST(NumberFormatTest, ShortestKnownValues) {
+    EXPECT_EQ(formatNumber(0.1 + 0.2), "0.30000000000000004");
+    EXPECT_EQ(formatNumber(0.1), "0.1");
+    EXPECT_EQ(formatNumber(3.0), "3");
+    EXPECT_EQ(formatNumber(-2.5), "-2.5");
+    EXPECT_EQ(formatNumber(-0.0), "-0");
+    EXPECT_EQ(formatNumber(1e21), "1e+21");
+    EXPECT_EQ(formatNumber(std::numeric_limits<double>::infinity()), "inf");
+    EXPECT_EQ(formatNumber(-std::numeric_limits<double>::infinity()), "-inf");
+    EXPECT_EQ(formatNumber(std::numeric_limits<double>::quiet_NaN()), "nan");
+}
+
+TEST(NumberFormatTest, FixedAndPrecisionMatchPrintf) {
+    const double values[] = { 0.0, 1.0 / 3.0, -2.5, 1234567.891, 1e-7, 6.02214076e23, 0.5, 1.5, 2.675,
+                              std::numeric_limits<double>::max(), std::numeric_limits<double>::denorm_min() };
+    for (double value : values) {
+        for (int precision : { 0, 1, 3, 6, 17, 40 }) {
+            char reference[kMaxFormattedNumber];
+            std::snprintf(reference, sizeof(reference), "%.*f", precision, value);
+            EXPECT_EQ(formatNumber(value, { NumberFormat::Fixed, precision }), reference) << value << " " << precision;
+            std::snprintf(reference, sizeof(reference), "%.*g", precision, value);
+            EXPECT_EQ(formatNumber(value, { NumberFormat::Precision, precision }), reference) << value << " " << precision;
+        }
+    }
+    // Точность за пределами диапазона ограничивается, буфер не переполняется
+    EXPECT_EQ(formatNumber(-std::numeric_limits<double>::max(), { NumberFormat::Fixed, 1000 }).size(), 310u + 1 + NumberFormatOptions::kMaxPrecision);
+    EXPECT_EQ(formatNumber(2.0, { NumberFormat::Fixed, -5 }), "2");
+}
+
+TEST(NumberFormatTest, OutputBufferWritesInOrder) {
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    std::string expected;
+    {
+        OutputBuffer output(file, 100);   // Малый порог: много сбросов и длинные строки через границу
+        for (int i = 0; i < 1000; ++i) {
+            output.appendNumber(i * 0.25);
+            output.append(i % 7 ? ";" : std::string(150, 'x'));
+            output.append('\n');
+            expected += formatNumber(i * 0.25) + (i % 7 ? ";" : std::string(150, 'x')) + "\n";
+        }
+    }
+    std::rewind(file);
+    std::string written(expected.size() + 1, '\0');
+    written.resize(std::fread(written.data(), 1, written.size(), file));
+    std::fclose(file);
+    EXPECT_EQ(written, expected);
+}
@@ -0,0 +1,121 @@
+#include <gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "translator.h"
+#include "optimizer.h"
+#include "incremental.h"
+
+static std::string longChain(const char* separator, int count) {
+    std::string expression = "x0";
+    for (int i = 1; i < count; ++i) expression += separator + std::string("x") + std::to_string(i);
+    return expression;
+}
+
+TEST(OptimizerTest, WithoutFastMathResultsAreIdentical) {
+    Translator calc;
+    const char* expressions[] = { "1+2+3+4+5+6+7+8+9+10", "(a+b)*(c+d*(e+f))", "a-b-c-d-e", "sqrt(a)+a^3*b/c-d" };
+    std::vector<double> values = { 1.5, 2.25, -3.0, 4.125, 0.3, 7.0 };
+    for (const char* expression : expressions) {
+        Program plain = calc.compile(expression);
+        Program optimized = calc.compile(expression, OptimizerOptions{});
+        EXPECT_EQ(optimized.code.size(), plain.code.size());
+        EXPECT_LE(optimized.stackDepth, plain.stackDepth);
+        EXPECT_EQ(calc.calculate(optimized, values), calc.calculate(plain, values)) << expression;
+    }
+}
+
+TEST(OptimizerTest, ReassociatesLongChainsIntoBalancedTrees) {
+    Translator calc;
+    OptimizerOptions fastMath;
+    fastMath.reassociate = true;
+
+    Program plain = calc.compile(longChain("+", 64));
+    Program balanced = calc.compile(longChain("+", 64), fastMath);
+    EXPECT_EQ(balanced.code.size(), plain.code.size());
+    // Левоглубокая цепочка требует глубину 2, сбалансированное дерево - log2(64) + 1
+    EXPECT_EQ(plain.stackDepth, 2u);
+    EXPECT_EQ(balanced.stackDepth, 7u);
+
+    std::vector<double> values(64);
+    for (int i = 0; i < 64; ++i) values[i] = i * 0.1 + 1.0;
+    EXPECT_NEAR(calc.calculate(balanced, values), calc.calculate(plain, values), 1e-9);
+
+    Program product = calc.compile(longChain("*", 16), fastMath);
+    std::vector<double> factors(16, 1.5);
+    EXPECT_NEAR(calc.calculate(product, factors), calc.calculate(calc.compile(longChain("*", 16)), factors), 1e-9);
+}
+
+TEST(OptimizerTest, OnlySameOperatorChainsAreFlattened) {
+    Translator calc;
+    OptimizerOptions fastMath;
+    fastMath.reassociate = true;
+    std::vector<double> values = { 10.0, 2.0, 3.0, 4.0, 5.0, 6.0 };
+    const char* expressions[] = { "a-b-c-d-e-f", "a/b/c/d/e/f", "(a+b)*(c+d)*(e+f)+a*b", "-(a+b+c+d)*e+f", "a+b*c+d+e/f+f^2" };
+    for (const char* expression : expressions) {
+        EXPECT_NEAR(calc.calculate(calc.compile(expression, fastMath), values),
+                    calc.calculate(calc.compile(expression), values), 1e-12) << expression;
+    }
+}
+
+static bool containsOpCode(const Program& program, OpCode opCode) {
+    return std::any_of(program.code.begin(), program.code.end(),
+                       [opCode](const Instruction& instruction) { return instruction.opCode == opCode; });
+}
+
+TEST(OptimizerTest, DivisionByPowerOfTwoBecomesExactMultiplication) {
+    Translator calc;
+    Program plain = calc.compile("x/4 + x/0.5 - x/1024");
+    Program optimized = calc.compile("x/4 + x/0.5 - x/1024", OptimizerOptions{});
+    EXPECT_FALSE(containsOpCode(optimized, OpCode::Divide));
+    EXPECT_FALSE(containsOpCode(optimized, OpCode::DivideConstant));
+    for (double x : { 1.0, 3.0, -0.1, 1e-310, 1.7e308, 123456.789, -0.0 }) {
+        EXPECT_EQ(calc.calculate(optimized, { x }), calc.calculate(plain, { x })) << x;
+    }
+    // Строковый путь: делитель-литерал - степень двойки
+    EXPECT_EQ(calc.calculate("3/8"), 0.375);
+    EXPECT_EQ(calc.calculate("1e-310/2"), 1e-310 / 2);
+}
+
+TEST(OptimizerTest, DivisionByOtherConstantsSkipsZeroCheck) {
+    Translator calc;
+    Program plain = calc.compile("x/100 + 1/3");
+    Program optimized = calc.compile("x/100 + 1/3", OptimizerOptions{});
+    EXPECT_FALSE(containsOpCode(optimized, OpCode::Divide));
+    EXPECT_TRUE(containsOpCode(optimized, OpCode::DivideConstant));
+    for (double x : { 0.0, 7.0, -12.5, 1e300 }) {
+        EXPECT_EQ(calc.calculate(optimized, { x }), calc.calculate(plain, { x }));
+    }
+
+    // Столбцовый и инкрементальный пути понимают DivideConstant
+    std::vector<double> xs = { 1.0, 2.0, 3.0 }, results(3);
+    calc.calculateBatch(optimized, { xs.data() }, xs.size(), results.data());
+    IncrementalEval incremental(optimized);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        EXPECT_EQ(results[i], calc.calculate(plain, { xs[i] }));
+        incremental.setVariable(0, xs[i]);
+        EXPECT_EQ(incremental.value(), results[i]);
+    }
+}
+
+TEST(OptimizerTest, ReciprocalDivisionUnderFastMath) {
+    Translator calc;
+    OptimizerOptions fastMath;
+    fastMath.reciprocalDivision = true;
+    Program optimized = calc.compile("x/100 - y/3", fastMath);
+    EXPECT_FALSE(containsOpCode(optimized, OpCode::Divide));
+    EXPECT_FALSE(containsOpCode(optimized, OpCode::DivideConstant));
+    EXPECT_NEAR(calc.calculate(optimized, { 250.0, 9.0 }), -0.5, 1e-12);
+}
+
+TEST(OptimizerTest, DivisionByZeroConstantStillThrows) {
+    Translator calc;
+    OptimizerOptions fastMath;
+    fastMath.reciprocalDivision = true;
+    Program optimized = calc.compile("x/0", fastMath);
+    EXPECT_TRUE(containsOpCode(optimized, OpCode::Divide));
+    EXPECT_THROW(calc.calculate(optimized, { 1.0 }), std::runtime_error);
+    EXPECT_THROW(calc.calculate("1/0"), std::runtime_error);
+}
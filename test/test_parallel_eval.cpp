@@ -0,0 +1,96 @@
+#include <gtest.h>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parallel_eval.h"
+
+static std::vector<Token> rpnOf(const std::string& input) {
+    Lexer lexer(input);
+    Parcer parser;
+    return parser.toRpn(lexer);
+}
+
+// Биты результата или текст ошибки: NaN и -0 тоже должны совпасть
+template <typename Evaluate>
+static std::string outcome(Evaluate evaluate) {
+    try {
+        const double value = evaluate();
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return std::to_string(bits);
+    }
+    catch (const std::runtime_error& e) {
+        return std::string("error:") + e.what();
+    }
+}
+
+static void expectSameResult(const std::vector<Token>& rpn, ThreadPool& pool, std::size_t grain, const std::string& input) {
+    Eval sequential;
+    ParallelEval parallel(pool, grain);
+    EXPECT_EQ(outcome([&] { return parallel.evaluateRpn(rpn); }), outcome([&] { return sequential.evaluateRpn(rpn); }))
+        << "input: " << input << ", grain " << grain;
+}
+
+static std::string randomExpression(std::mt19937& generator, int depth) {
+    static const char* const atoms[] = { "3", "2", "1.5", "0.1", "-7", "3e2", "0" };
+    static const char* const operators[] = { "+", "-", "*", "/", "^", " - -", "*-" };
+    std::uniform_int_distribution<int> pick(0, 11);
+    std::uniform_int_distribution<int> length(1, 6);
+    std::string text;
+    for (int i = 0, n = length(generator); i < n; ++i) {
+        if (i > 0) text += operators[pick(generator) % std::size(operators)];
+        const int kind = depth > 0 ? pick(generator) : 0;
+        if (kind >= 9) text += "(" + randomExpression(generator, depth - 1) + ")";
+        else if (kind == 8) text += "max(" + randomExpression(generator, depth - 1) + ", " + randomExpression(generator, depth - 1) + ")";
+        else if (kind == 7) text += "sin(" + randomExpression(generator, depth - 1) + ")";
+        else if (kind == 6) text += "-(" + randomExpression(generator, depth - 1) + ")";
+        else text += atoms[pick(generator) % std::size(atoms)];
+    }
+    return text;
+}
+
+TEST(ParallelEvalTest, BitIdenticalOnRandomExpressions) {
+    ThreadPool pool(3);
+    std::mt19937 generator(11);
+    for (int round = 0; round < 300; ++round) {
+        const std::string input = randomExpression(generator, 4);
+        const std::vector<Token> rpn = rpnOf(input);
+        for (std::size_t grain : { 1, 2, 3, 8, 64 }) {
+            expectSameResult(rpn, pool, grain, input);
+            if (HasFailure()) return;
+        }
+    }
+}
+
+TEST(ParallelEvalTest, ErrorsMatchSequential) {
+    ThreadPool pool(2);
+    // Первой сообщается ошибка, которую встретил бы последовательный проход
+    const char* cases[] = { "1 + 2/0 + x", "x + 1/0", "(1 - 1/0) * (2 + y)", "1 + y*2 + sqrt(4)/(1 - 1)" };
+    for (const char* input : cases) {
+        const std::vector<Token> rpn = rpnOf(input);
+        for (std::size_t grain : { 1, 2, 5 }) expectSameResult(rpn, pool, grain, input);
+    }
+    std::vector<Token> broken = rpnOf("1 + 2 + 3");
+    broken.pop_back();
+    expectSameResult(broken, pool, 1, "1 2 + 3");
+    broken.push_back(Token::createLeftParen());
+    expectSameResult(broken, pool, 1, "1 2 + 3 (");
+}
+
+TEST(ParallelEvalTest, DeepNestingFallsBackToSequential) {
+    ThreadPool pool(2);
+    std::string input = "1";
+    for (int i = 0; i < 2000; ++i) input = std::to_string(i % 7) + " - (" + input + ")*0.5";
+    expectSameResult(rpnOf(input), pool, 4, "deep");
+}
+
+TEST(ParallelEvalTest, LargeExpression) {
+    ThreadPool pool(4);
+    std::mt19937 generator(3);
+    std::string input = "0";
+    while (input.size() < 400000) input += " + " + randomExpression(generator, 3);
+    expectSameResult(rpnOf(input), pool, 1024, "large");
+}
@@ -0,0 +1,84 @@
+#include <gtest.h>
+#include <random>
+#include <string>
+
+#include "parallel_lexer.h"
+#include "parser.h"
+
+static TokenBuffer sequentialTokens(const std::string& input) {
+    Lexer lexer(input);
+    TokenBuffer tokens;
+    lexer.tokenizeAll(tokens);
+    return tokens;
+}
+
+static void expectSameBuffers(const TokenBuffer& actual, const TokenBuffer& expected, const std::string& input) {
+    EXPECT_EQ(actual.types, expected.types) << input;
+    EXPECT_EQ(actual.operators, expected.operators) << input;
+    EXPECT_EQ(actual.values, expected.values) << input;
+    EXPECT_EQ(actual.offsets, expected.offsets) << input;
+    EXPECT_EQ(actual.lengths, expected.lengths) << input;
+    EXPECT_EQ(actual.error, expected.error) << input;
+}
+
+// Выражение, где минусы, пробелы и скобки часто попадают на границы кусков
+static std::string randomExpression(std::mt19937& generator, std::size_t terms) {
+    static const char* const operands[] = { "x", "y1", "2.5", "1e-3", "0x1p2", "(z)", "max(a, -b)", "sin (t)", "-(4)", "7." };
+    static const char* const operators[] = { "+", "-", "*", "/", "^", " - ", "- -", "*-", " ", "  ", ",", ")", "(" };
+    std::uniform_int_distribution<std::size_t> operand(0, std::size(operands) - 1);
+    std::uniform_int_distribution<std::size_t> op(0, std::size(operators) - 1);
+    std::string text;
+    for (std::size_t i = 0; i < terms; ++i) {
+        if (i > 0) text += operators[op(generator)];
+        text += operands[operand(generator)];
+    }
+    return text;
+}
+
+TEST(ParallelLexerTest, MatchesSequentialForAnyChunkSize) {
+    ThreadPool pool(3);
+    std::mt19937 generator(7);
+    TokenBuffer tokens;
+    for (int round = 0; round < 200; ++round) {
+        const std::string input = randomExpression(generator, 1 + round % 40);
+        const TokenBuffer expected = sequentialTokens(input);
+        for (std::size_t chunkBytes : { 1, 2, 3, 5, 8, 13, 64, 4096 }) {
+            ParallelLexer(pool, chunkBytes).tokenizeAll(input, tokens);
+            expectSameBuffers(tokens, expected, input);
+            if (HasFailure()) return;
+        }
+    }
+}
+
+TEST(ParallelLexerTest, EdgeCasesAndErrors) {
+    ThreadPool pool(2);
+    TokenBuffer tokens;
+    const char* cases[] = {
+        "", "   ", "-1", "1 -1", "(-1)-(-1)", "a - - b", "f (1) - 2", "1e+5-1e-5", "x #", "1 + 2 $ 3 - 4 @",
+        "1 2 3 - 4", "aaaaaaaaaaaaaaaaaaaaaaaaaaaa-1", "0x1p-2 - 0x.8p+1"
+    };
+    ParallelLexer reused(pool, 3);
+    for (const char* input : cases) {
+        reused.tokenizeAll(input, tokens);
+        expectSameBuffers(tokens, sequentialTokens(input), input);
+        for (std::size_t chunkBytes : { 1, 2, 4, 7 }) {
+            ParallelLexer(pool, chunkBytes).tokenizeAll(input, tokens);
+            expectSameBuffers(tokens, sequentialTokens(input), input);
+        }
+    }
+}
+
+TEST(ParallelLexerTest, LargeExpressionParsesLikeSequential) {
+    ThreadPool pool(4);
+    std::string input = "0";
+    for (int i = 0; i < 20000; ++i) input += " - " + std::to_string(i % 97) + "*-x" + (i % 3 ? "/2" : "^2");
+
+    TokenBuffer tokens;
+    ParallelLexer(pool, 1000).tokenizeAll(input, tokens);
+    const TokenBuffer expected = sequentialTokens(input);
+    expectSameBuffers(tokens, expected, "large");
+
+    Parcer parallelParser, sequentialParser;
+    Lexer lexer(input);
+    EXPECT_EQ(parallelParser.toRpn(tokens, input).size(), sequentialParser.toRpn(lexer).size());
+}
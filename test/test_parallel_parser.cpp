@@ -0,0 +1,107 @@
+#include <gtest.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parallel_parser.h"
+#include "parallel_lexer.h"
+
+// RPN или текст ошибки в сравнимом виде
+static std::vector<std::string> describe(const std::vector<Token>& rpn) {
+    std::vector<std::string> items;
+    for (const Token& token : rpn) items.push_back(std::to_string(static_cast<int>(token.type)) + ":" + token.content);
+    return items;
+}
+
+template <typename Parse>
+static std::vector<std::string> outcome(Parse parse) {
+    try {
+        return describe(parse());
+    }
+    catch (const std::runtime_error& e) {
+        return { std::string("error:") + e.what() };
+    }
+}
+
+static void expectSameRpn(const std::string& input, ThreadPool& pool, std::size_t grain) {
+    Lexer lexer(input);
+    TokenBuffer tokens;
+    lexer.tokenizeAll(tokens);
+    Parcer sequential;
+    ParallelParser parallel(pool, grain);
+    EXPECT_EQ(outcome([&] { return parallel.toRpn(tokens, input); }), outcome([&] { return sequential.toRpn(tokens, input); }))
+        << "input: " << input << ", grain " << grain;
+}
+
+static std::string randomExpression(std::mt19937& generator, int depth) {
+    static const char* const atoms[] = { "x", "2", "1.5", "y", "-z", "3e2" };
+    static const char* const operators[] = { "+", "-", "*", "/", "^", " - -", "*-" };
+    std::uniform_int_distribution<int> pick(0, 9);
+    std::uniform_int_distribution<int> length(1, 6);
+    std::string text;
+    for (int i = 0, n = length(generator); i < n; ++i) {
+        if (i > 0) text += operators[pick(generator) % std::size(operators)];
+        const int kind = depth > 0 ? pick(generator) : 0;
+        if (kind >= 8) text += "(" + randomExpression(generator, depth - 1) + ")";
+        else if (kind == 7) text += "max(" + randomExpression(generator, depth - 1) + ", " + randomExpression(generator, depth - 1) + ")";
+        else if (kind == 6) text += "-(" + randomExpression(generator, depth - 1) + ")";
+        else text += atoms[pick(generator) % std::size(atoms)];
+    }
+    return text;
+}
+
+TEST(ParallelParserTest, MatchesSequentialOnRandomExpressions) {
+    ThreadPool pool(3);
+    std::mt19937 generator(5);
+    for (int round = 0; round < 300; ++round) {
+        const std::string input = randomExpression(generator, 4);
+        for (std::size_t grain : { 1, 2, 3, 8, 64 }) {
+            expectSameRpn(input, pool, grain);
+            if (HasFailure()) return;
+        }
+    }
+}
+
+TEST(ParallelParserTest, ErrorsMatchSequential) {
+    ThreadPool pool(2);
+    const char* cases[] = {
+        "1 + (2 * 3", "1 + 2) * 3", ")1 + 2(", "1 + + 2", "1 + 2 3", "(1, 2) + 3", "1 + 2,", "max(1) + 2",
+        "foo(1) + 2", "1 + () - 2", "1 + 2 # 3", "1 * (2 + 3) * (4 + ", "-(1 + 2) - (3 * (4 - 5)) - 6"
+    };
+    for (const char* input : cases) {
+        for (std::size_t grain : { 1, 2, 5 }) expectSameRpn(input, pool, grain);
+    }
+}
+
+TEST(ParallelParserTest, EmptyBufferIsParserError) {
+    ThreadPool pool(2);
+    const TokenBuffer empty;
+    Parcer sequential;
+    ParallelParser parallel(pool, 1);
+    const std::vector<std::string> expected = { "error:Parser error: operand expected" };
+    EXPECT_EQ(outcome([&] { return sequential.toRpn(empty, ""); }), expected);
+    EXPECT_EQ(outcome([&] { return parallel.toRpn(empty, ""); }), expected);
+    // Так же, как пустая строка через лексер
+    expectSameRpn("", pool, 1);
+}
+
+TEST(ParallelParserTest, DeepNestingFallsBackToSequential) {
+    ThreadPool pool(2);
+    std::string input = "1";
+    for (int i = 0; i < 2000; ++i) input = "(" + input + "+" + std::to_string(i) + ")*2";
+    expectSameRpn(input, pool, 4);
+}
+
+TEST(ParallelParserTest, LargeExpressionEndToEnd) {
+    ThreadPool pool(4);
+    std::mt19937 generator(9);
+    std::string input = "0";
+    while (input.size() < 400000) input += " - " + randomExpression(generator, 3);
+
+    TokenBuffer tokens;
+    ParallelLexer(pool, 4096).tokenizeAll(input, tokens);
+    Parcer sequential;
+    ParallelParser parallel(pool, 1024);
+    EXPECT_EQ(describe(parallel.toRpn(tokens, input)), describe(sequential.toRpn(tokens, input)));
+}
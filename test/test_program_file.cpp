@@ -0,0 +1,100 @@
+#include <gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "translator.h"
+#include "program_file.h"
+
+static std::string temporaryLibraryPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::string readBytes(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+static void writeBytes(const std::string& path, const std::string& bytes) {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+TEST(ProgramLibraryTest, RoundTripPreservesPrograms) {
+    Translator calc;
+    const char* expressions[] = { "a*x+b", "42", "sqrt(x*x+y*y)/100", "-rate^2+rate^0.5", "max(a, b)-min(a, 3)/4" };
+    std::vector<Program> programs;
+    for (const char* expression : expressions) programs.push_back(calc.compile(expression, OptimizerOptions{}));
+
+    const std::string path = temporaryLibraryPath("translator_roundtrip.trpl");
+    ProgramLibrary::save(path, programs);
+    ProgramLibrary library = ProgramLibrary::load(path);
+    ASSERT_EQ(library.size(), programs.size());
+
+    for (std::size_t i = 0; i < programs.size(); ++i) {
+        const ProgramView& view = library[i];
+        Program copy = view.toProgram();
+        ASSERT_EQ(copy.code.size(), programs[i].code.size());
+        for (std::size_t j = 0; j < copy.code.size(); ++j) {
+            EXPECT_EQ(copy.code[j].opCode, programs[i].code[j].opCode);
+            EXPECT_EQ(copy.code[j].operand, programs[i].code[j].operand);
+        }
+        EXPECT_EQ(copy.constants, programs[i].constants);
+        EXPECT_EQ(copy.variables, programs[i].variables);
+        EXPECT_EQ(copy.stackDepth, programs[i].stackDepth);
+
+        std::vector<double> values(view.variableCount(), 2.5);
+        EXPECT_EQ(calc.calculate(view, values), calc.calculate(programs[i], values)) << expressions[i];
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(ProgramLibraryTest, EmptyLibrary) {
+    const std::string path = temporaryLibraryPath("translator_empty.trpl");
+    ProgramLibrary::save(path, {});
+    EXPECT_EQ(ProgramLibrary::load(path).size(), 0u);
+    EXPECT_THROW(ProgramLibrary::load(path).at(0), std::out_of_range);
+    std::filesystem::remove(path);
+}
+
+TEST(ProgramLibraryTest, RejectsCorruptedFiles) {
+    Translator calc;
+    const std::string path = temporaryLibraryPath("translator_corrupted.trpl");
+    ProgramLibrary::save(path, { calc.compile("x/100 + 2", OptimizerOptions{}) });
+    const std::string valid = readBytes(path);
+    ASSERT_NO_THROW(ProgramLibrary::load(path));
+
+    std::uint64_t codeOffset = 0, constantsOffset = 0;
+    std::memcpy(&codeOffset, valid.data() + 48, sizeof(codeOffset));
+    std::memcpy(&constantsOffset, valid.data() + 56, sizeof(constantsOffset));
+
+    auto expectRejected = [&](std::string bytes) {
+        writeBytes(path, bytes);
+        EXPECT_THROW(ProgramLibrary::load(path), std::runtime_error);
+    };
+    std::string bytes = valid;
+    bytes[0] = 'X';
+    expectRejected(bytes);                                  // Сигнатура
+    bytes = valid;
+    bytes[4] = 2;
+    expectRejected(bytes);                                  // Версия
+    expectRejected(valid.substr(0, valid.size() - 1));      // Обрезанный файл
+    expectRejected(valid.substr(0, 20));
+    bytes = valid;
+    bytes[codeOffset + 4] = 7;
+    expectRejected(bytes);                                  // PushVariable: слота 7 нет
+    bytes = valid;
+    bytes[codeOffset] = static_cast<char>(0x7f);
+    expectRejected(bytes);                                  // Неизвестный код операции
+    bytes = valid;
+    std::memset(&bytes[constantsOffset], 0, 8 * 2);
+    expectRejected(bytes);                                  // DivideConstant на ноль
+
+    std::filesystem::remove(path);
+    EXPECT_THROW(ProgramLibrary::load(path), std::runtime_error);
+}
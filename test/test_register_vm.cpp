@@ -0,0 +1,57 @@
+#include <gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "translator.h"
+#include "register_vm.h"
+
+TEST(RegisterVMTest, MatchesStackMachineBitForBit) {
+    Translator calc;
+    const char* expressions[] = {
+        "x", "42", "-x", "a*x+b", "(a+b)*(c-d)/(a-c)", "sqrt(a*a+b*b)", "x^2+x^-3+x^0.5",
+        "max(a, b) - min(c, d) + abs(-x)", "x/100 + x/4 - 1/3", "exp(-x*x/2)/sqrt(2*3.14159)",
+        "((((a+1)*2+b)*3+c)*4+d)*5", "a-(b-(c-(d-(x-1))))", "pow(a, b) + log(x) * cos(c) - sin(d)"
+    };
+    std::vector<double> values = { 1.25, -2.5, 3.0, 0.75, 2.0 };
+    for (const char* expression : expressions) {
+        Program program = calc.compile(expression);
+        RegisterProgram registers = calc.compileRegisters(expression);
+        std::vector<double> arguments(values.begin(), values.begin() + program.variables.size());
+        EXPECT_EQ(calc.calculate(registers, arguments), calc.calculate(program, arguments)) << expression;
+    }
+}
+
+TEST(RegisterVMTest, LeavesNeedNoInstructions) {
+    Translator calc;
+    RegisterProgram leaf = calc.compileRegisters("x");
+    EXPECT_TRUE(leaf.code.empty());
+    EXPECT_EQ(calc.calculate(leaf, { 7.5 }), 7.5);
+
+    RegisterProgram affine = calc.compileRegisters("a*x+b");
+    EXPECT_EQ(affine.code.size(), 2u);
+    EXPECT_EQ(affine.registerCount, affine.temporaryBase() + 1);
+}
+
+TEST(RegisterVMTest, TemporariesAreReused) {
+    Translator calc;
+    std::string expression = "x0";
+    for (int i = 1; i < 200; ++i) expression += "+x" + std::to_string(i) + "*x" + std::to_string(i);
+    Program program = calc.compile(expression);
+    RegisterProgram registers = RegisterCompiler::compile(program);
+    // Временных регистров не больше, чем глубина стека
+    EXPECT_LE(registers.registerCount - registers.temporaryBase(), program.stackDepth);
+
+    std::vector<double> values(program.variables.size());
+    for (std::size_t i = 0; i < values.size(); ++i) values[i] = 0.01 * static_cast<double>(i);
+    EXPECT_EQ(calc.calculate(registers, values), calc.calculate(program, values));
+}
+
+TEST(RegisterVMTest, ReportsErrors) {
+    Translator calc;
+    RegisterProgram program = calc.compileRegisters("a/b");
+    EXPECT_THROW(calc.calculate(program, { 1.0, 0.0 }), std::runtime_error);
+    EXPECT_THROW(calc.calculate(program, { 1.0 }), std::runtime_error);
+    EXPECT_EQ(calc.calculate(program, { 1.0, 4.0 }), 0.25);
+    EXPECT_THROW(calc.calculate(calc.compileRegisters("sqrt(x)"), { -1.0 }), std::runtime_error);
+}
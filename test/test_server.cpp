@@ -0,0 +1,168 @@
+#include <gtest.h>
+
+#if defined(__linux__)
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.h"
+
+static int connectUnix(const std::string& path) {
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    if (connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(descriptor);
+        return -1;
+    }
+    return descriptor;
+}
+
+// Читает до закрытия соединения сервером
+static std::string readAll(int descriptor) {
+    std::string received;
+    char buffer[4096];
+    for (ssize_t length; (length = read(descriptor, buffer, sizeof(buffer))) > 0;) received.append(buffer, static_cast<std::size_t>(length));
+    return received;
+}
+
+class ServerTest : public ::testing::Test {
+protected:
+    std::string path = (std::filesystem::temp_directory_path() / ("translator_test_" + std::to_string(getpid()) + ".sock")).string();
+    std::unique_ptr<EvaluationServer> server;
+    std::thread loop;
+
+    void SetUp() override {
+        ServerOptions options;
+        options.unixPath = path;
+        options.workerCount = 2;
+        options.maxBatch = 3;
+        server = std::make_unique<EvaluationServer>(options);
+        loop = std::thread([this] { server->run(); });
+    }
+
+    void TearDown() override {
+        server->stop();
+        loop.join();
+        server.reset();
+    }
+};
+
+TEST_F(ServerTest, AnswersPipelinedRequestsInOrder) {
+    int descriptor = connectUnix(path);
+    ASSERT_GE(descriptor, 0);
+    // Последняя строка без '\n' считается запросом после закрытия записи
+    const std::string requests = "1+2\n2*(3+4)\n1/0\n\n10/4\r\nsqrt(16)\n2^10\n7-";
+    ASSERT_EQ(write(descriptor, requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+    shutdown(descriptor, SHUT_WR);
+
+    std::string responses = readAll(descriptor);
+    close(descriptor);
+    EXPECT_EQ(responses,
+              "3\n14\n"
+              "Error: Eval error: division by zero\n"
+              "Error: Parser error: operand expected\n"
+              "2.5\n4\n1024\n"
+              "Error: Parser error: operand expected\n");
+}
+
+TEST_F(ServerTest, ServesSeveralClients) {
+    std::vector<std::thread> clients;
+    std::vector<std::string> responses(4);
+    for (std::size_t i = 0; i < responses.size(); ++i) {
+        clients.emplace_back([&, i] {
+            int descriptor = connectUnix(path);
+            if (descriptor < 0) return;
+            std::string requests;
+            for (int j = 0; j < 500; ++j) requests += std::to_string(i) + "+" + std::to_string(j) + "\n";
+            for (std::size_t offset = 0; offset < requests.size();) {
+                ssize_t written = write(descriptor, requests.data() + offset, requests.size() - offset);
+                if (written <= 0) break;
+                offset += static_cast<std::size_t>(written);
+            }
+            shutdown(descriptor, SHUT_WR);
+            responses[i] = readAll(descriptor);
+            close(descriptor);
+        });
+    }
+    for (std::thread& client : clients) client.join();
+
+    for (std::size_t i = 0; i < responses.size(); ++i) {
+        std::string expected;
+        for (int j = 0; j < 500; ++j) expected += std::to_string(i + j) + "\n";
+        EXPECT_EQ(responses[i], expected);
+    }
+}
+
+TEST_F(ServerTest, RejectsRequestsOverLimits) {
+    int descriptor = connectUnix(path);
+    ASSERT_GE(descriptor, 0);
+    const std::string deep = std::string(300, '(') + "1" + std::string(300, ')');
+    const std::string requests = "1+2\n" + deep + "\n2*3\n";
+    ASSERT_EQ(write(descriptor, requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+    shutdown(descriptor, SHUT_WR);
+
+    std::string responses = readAll(descriptor);
+    close(descriptor);
+    EXPECT_EQ(responses, "3\nError: Limit error: nesting deeper than 256\n6\n");
+}
+
+TEST_F(ServerTest, RejectsOverlongLineWithoutNewline) {
+    int descriptor = connectUnix(path);
+    ASSERT_GE(descriptor, 0);
+    // Если соединение зависнет, чтение завершится по таймауту, а не заблокирует тест
+    timeval timeout{ 10, 0 };
+    setsockopt(descriptor, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    // Больше буфера сервера и лимита ввода, ни одного '\n'; затем обычный запрос
+    std::thread writer([descriptor] {
+        const std::string chunk(64 * 1024, '1');
+        for (int i = 0; i < 96; ++i) {
+            if (write(descriptor, chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size())) return;
+        }
+        const std::string tail = "\n1+2\n";
+        [[maybe_unused]] ssize_t written = write(descriptor, tail.data(), tail.size());
+        shutdown(descriptor, SHUT_WR);
+    });
+    std::string responses = readAll(descriptor);
+    shutdown(descriptor, SHUT_RDWR);   // Освобождает писателя, если сервер перестал читать
+    writer.join();
+    close(descriptor);
+    EXPECT_EQ(responses, "Error: Limit error: input longer than 1048576 bytes\n3\n");
+}
+
+TEST(ServerLimitsTest, PendingInputFollowsInputLimit) {
+    // Лимит строки выше прежнего фиксированного буфера в 4 MiB: такая строка дочитывается и вычисляется
+    ServerOptions options;
+    options.unixPath = (std::filesystem::temp_directory_path() / ("translator_limits_" + std::to_string(getpid()) + ".sock")).string();
+    options.workerCount = 1;
+    options.limits.maxInputBytes = 6 << 20;
+    EvaluationServer server(options);
+    std::thread loop([&server] { server.run(); });
+
+    int descriptor = connectUnix(options.unixPath);
+    ASSERT_GE(descriptor, 0);
+    timeval timeout{ 10, 0 };
+    setsockopt(descriptor, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::thread writer([descriptor] {
+        const std::string request = "1" + std::string(5 << 20, '0') + "e-5242880\n" + std::string(7 << 20, '2') + "\n";
+        [[maybe_unused]] ssize_t written = write(descriptor, request.data(), request.size());
+        shutdown(descriptor, SHUT_WR);
+    });
+    std::string responses = readAll(descriptor);
+    shutdown(descriptor, SHUT_RDWR);
+    writer.join();
+    close(descriptor);
+    server.stop();
+    loop.join();
+    EXPECT_EQ(responses, "1\nError: Limit error: input longer than 6291456 bytes\n");
+}
+#endif
@@ -0,0 +1,192 @@
+#include <gtest.h>
+
+#if defined(__linux__)
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "shm_ring.h"
+
+TEST(SpscRingTest, WrapsAroundAndReportsFull) {
+    auto ring = std::make_unique<SpscRing<256>>();
+    std::string record;
+    EXPECT_FALSE(ring->tryRead(record));
+
+    // Записи разной длины, чтобы маркер перехода попадал в разные места
+    for (int round = 0; round < 200; ++round) {
+        std::string payload(static_cast<std::size_t>(round % 37), static_cast<char>('a' + round % 26));
+        ASSERT_TRUE(ring->tryWrite(std::to_string(round) + ":", payload));
+        ASSERT_TRUE(ring->tryRead(record));
+        EXPECT_EQ(record, std::to_string(round) + ":" + payload);
+    }
+
+    int written = 0;
+    while (ring->tryWrite(std::string(20, 'x'))) written++;
+    EXPECT_GT(written, 0);
+    EXPECT_LE(written * 24, 256);
+    for (int i = 0; i < written; ++i) ASSERT_TRUE(ring->tryRead(record));
+    EXPECT_TRUE(ring->empty());
+    EXPECT_THROW(ring->tryWrite(std::string(200, 'x')), std::length_error);
+}
+
+// Подменяет длину записи в кольце, как это мог бы сделать клиент с ошибкой
+struct SpscRingCorruptor {
+    template <std::size_t Capacity>
+    static std::size_t tailOffset(const SpscRing<Capacity>& ring) {
+        return static_cast<std::size_t>(ring.tail.load() % Capacity);
+    }
+    template <std::size_t Capacity>
+    static void setLength(SpscRing<Capacity>& ring, std::size_t offset, std::uint32_t length) {
+        std::memcpy(ring.data + offset, &length, sizeof(length));
+    }
+};
+
+TEST(SpscRingTest, RejectsCorruptRecordLengths) {
+    auto ring = std::make_unique<SpscRing<256>>();
+    std::string record;
+
+    // Длина больше допустимой записи
+    ASSERT_TRUE(ring->tryWrite("abc"));
+    SpscRingCorruptor::setLength(*ring, 0, 1000);
+    EXPECT_THROW(ring->tryRead(record), std::runtime_error);
+
+    // Допустимая длина, но запись выходит за записанные байты
+    SpscRingCorruptor::setLength(*ring, 0, 100);
+    EXPECT_THROW(ring->tryRead(record), std::runtime_error);
+
+    // Запись у конца буфера, которая выходила бы за data[Capacity]
+    ring->discardAll();
+    EXPECT_TRUE(ring->empty());
+    for (int i = 0; i < 7; ++i) {
+        ASSERT_TRUE(ring->tryWrite(std::string(20, 'x')));
+        ASSERT_TRUE(ring->tryRead(record));
+    }
+    ASSERT_TRUE(ring->tryWrite("tail"));
+    std::size_t offset = SpscRingCorruptor::tailOffset(*ring);
+    ASSERT_GT(offset, 128u);
+    SpscRingCorruptor::setLength(*ring, offset, 100);
+    EXPECT_THROW(ring->tryRead(record), std::runtime_error);
+
+    // После discardAll кольцо снова пригодно
+    ring->discardAll();
+    ASSERT_TRUE(ring->tryWrite("ok"));
+    ASSERT_TRUE(ring->tryRead(record));
+    EXPECT_EQ(record, "ok");
+}
+
+TEST(SpscRingTest, TransfersBetweenThreads) {
+    auto ring = std::make_unique<SpscRing<1024>>();
+    constexpr int kCount = 20000;
+    std::thread producer([&] {
+        // Маленький цикл ожидания, чтобы чаще доходило до futex
+        for (int i = 0; i < kCount; ++i) ring->write(std::to_string(i), {}, 8);
+    });
+    std::string record;
+    for (int i = 0; i < kCount; ++i) {
+        ASSERT_TRUE(ring->waitReadable(8));
+        ASSERT_TRUE(ring->tryRead(record));
+        ASSERT_EQ(record, std::to_string(i));
+    }
+    producer.join();
+}
+
+TEST(ShmEvaluationTest, ClientRoundTrips) {
+    const std::string name = "/translator_test_" + std::to_string(getpid());
+    ShmEvaluationServer server(name, 2, 100);
+    server.start();
+    {
+        ShmClient first(name, 100);
+        ShmClient second(name, 100);
+        EXPECT_THROW(ShmClient(name, 100), std::runtime_error);   // Свободных слотов нет
+
+        EXPECT_EQ(first.calculate("2*(3+4)"), 14.0);
+        EXPECT_EQ(second.calculate("2^10-1"), 1023.0);
+        EXPECT_THROW(first.calculate("1/0"), std::runtime_error);
+        EXPECT_EQ(first.calculate("sqrt(16)"), 4.0);
+        for (int i = 0; i < 1000; ++i) ASSERT_EQ(second.calculate(std::to_string(i) + "+1"), i + 1.0);
+    }
+    // Слот освобождается вместе с клиентом
+    ShmClient third(name, 100);
+    EXPECT_EQ(third.calculate("-1.5"), -1.5);
+    server.stop();
+    EXPECT_THROW(third.calculate("1+1"), std::runtime_error);
+}
+
+TEST(ShmEvaluationTest, ReclaimsSlotsOfCrashedClients) {
+    const std::string name = "/translator_test_crash_" + std::to_string(getpid());
+    ShmEvaluationServer server(name, 2, 100);
+    server.start();
+    // Каждый потомок занимает слот, отправляет запрос и завершается, не прочитав ответ и не освободив слот
+    for (int i = 0; i < 4; ++i) {
+        pid_t child = fork();
+        ASSERT_GE(child, 0);
+        if (child == 0) {
+            ShmMapping mapping(name, 0, false);
+            ShmRegion* region = static_cast<ShmRegion*>(mapping.data());
+            auto* client = new ShmClient(name, 100);
+            static_cast<void>(client);
+            for (std::uint32_t slot = 0; slot < region->slotCount; ++slot) {
+                ShmSlot& owned = region->slots[slot];
+                if (owned.owner.load() != getpid()) continue;
+                const std::uint64_t id = owned.nextRequest.fetch_add(1);
+                owned.requests.write(std::string_view(reinterpret_cast<const char*>(&id), sizeof(id)), "1+1", 100);
+                while (owned.responses.empty()) std::this_thread::yield();
+            }
+            _exit(0);
+        }
+        int status = 0;
+        ASSERT_EQ(waitpid(child, &status, 0), child);
+        ASSERT_TRUE(WIFEXITED(status));
+    }
+    // Ответ "2" прежнему владельцу не принимается за ответ новому клиенту
+    ShmClient first(name, 100);
+    ShmClient second(name, 100);
+    EXPECT_EQ(first.calculate("5*5"), 25.0);
+    EXPECT_EQ(second.calculate("6*7"), 42.0);
+    EXPECT_THROW(ShmClient(name, 100), std::runtime_error);   // Живые владельцы слоты не теряют
+}
+
+TEST(ShmEvaluationTest, ClientFailsWhenServerProcessDies) {
+    const std::string name = "/translator_test_server_" + std::to_string(getpid());
+    int ready[2];
+    ASSERT_EQ(pipe(ready), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        ShmEvaluationServer server(name, 1, 100);
+        server.start();
+        [[maybe_unused]] ssize_t written = write(ready[1], "1", 1);
+        for (;;) pause();
+    }
+    char signal = 0;
+    ASSERT_EQ(read(ready[0], &signal, 1), 1);
+    close(ready[0]);
+    close(ready[1]);
+
+    ShmClient client(name, 100);
+    EXPECT_EQ(client.calculate("2+2"), 4.0);
+    // SIGKILL: сервер не выставляет shuttingDown и никого не будит
+    kill(child, SIGKILL);
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(client.calculate("3+3"), std::runtime_error);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_THROW(ShmClient(name, 100), std::runtime_error);
+
+    // Имя убитого сервера осталось; новый сервер заменяет объект, а не падает с "File exists"
+    ShmEvaluationServer restarted(name, 1, 100);
+    restarted.start();
+    ShmClient reconnected(name, 100);
+    EXPECT_EQ(reconnected.calculate("3+3"), 6.0);
+    // Объект живого сервера не отбирается
+    EXPECT_THROW(ShmEvaluationServer(name, 1, 100), std::runtime_error);
+}
+#endif
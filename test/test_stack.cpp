@@ -0,0 +1,87 @@
+#include <gtest.h>
+#include <type_traits>
+#include <stdexcept>
+#include <deque>
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+
+#include "stack.h"
+
+TEST(StackTest, Basic_PushPopTop) {
+    ds::Stack<int> st;
+    st.push(1);
+    st.push(2);
+    EXPECT_EQ(st.top(), 2);
+    st.pop();
+    EXPECT_EQ(st.top(), 1);
+    EXPECT_EQ(st.size(), 1u);
+    st.pop();
+    EXPECT_TRUE(st.empty());
+    EXPECT_THROW(st.pop(), std::out_of_range);
+    EXPECT_THROW(st.top(), std::out_of_range);
+}
+
+TEST(StackTest, Deque_Container) {
+    ds::Stack<int, std::deque> st;
+    st.push(7);
+    EXPECT_EQ(st.top(), 7);
+}
+
+TEST(StackTest, Reserve_ClearKeepsCapacity) {
+    ds::Stack<double> st;
+    st.reserve(64);
+    EXPECT_GE(st.capacity(), 64u);
+    for (int i = 0; i < 64; ++i) st.push(i);
+    st.clear();
+    EXPECT_TRUE(st.empty());
+    EXPECT_GE(st.capacity(), 64u);
+    st.shrink_to_fit();
+    EXPECT_EQ(st.capacity(), 0u);
+}
+
+TEST(StackTest, Pmr_PreallocatedBufferNoUpstream) {
+    // Вся память берется из буфера; выход за его пределы бросит bad_alloc
+    std::array<std::byte, 4096> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+    ds::pmr::Stack<double> st{ std::pmr::polymorphic_allocator<double>(&arena) };
+    st.reserve(128);
+    for (int i = 0; i < 128; ++i) st.push(i);
+    EXPECT_EQ(st.size(), 128u);
+    EXPECT_DOUBLE_EQ(st.top(), 127.0);
+    EXPECT_EQ(st.get_allocator().resource(), &arena);
+
+    ds::pmr::Stack<double> copy(st);
+    EXPECT_EQ(copy.size(), 128u);
+
+    // Копия с распределителем остается в той же арене
+    ds::pmr::Stack<double> arenaCopy(st, st.get_allocator());
+    EXPECT_EQ(arenaCopy.size(), 128u);
+    EXPECT_DOUBLE_EQ(arenaCopy.top(), 127.0);
+    EXPECT_EQ(arenaCopy.get_allocator().resource(), &arena);
+
+    // Вложенный стек получает память контейнера (uses-allocator construction)
+    std::pmr::vector<ds::pmr::Stack<double>> nested(&arena);
+    nested.reserve(2);
+    nested.push_back(st);
+    nested.emplace_back();
+    EXPECT_EQ(nested[0].size(), 128u);
+    EXPECT_EQ(nested[0].get_allocator().resource(), &arena);
+    EXPECT_EQ(nested[1].get_allocator().resource(), &arena);
+}
+
+TEST(StackTest, Pmr_MoveAssignAcrossResourcesMayThrow) {
+    using PmrStack = ds::pmr::Stack<int>;
+    // Разные memory_resource: перенос копирует элементы и может бросить
+    static_assert(!std::is_nothrow_move_assignable_v<PmrStack>);
+    static_assert(std::is_nothrow_move_assignable_v<ds::Stack<int>>);
+    static_assert(std::is_nothrow_move_constructible_v<PmrStack>);
+
+    PmrStack source;
+    for (int i = 0; i < 1000; ++i) source.push(i);
+    std::array<std::byte, 256> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    PmrStack target{ std::pmr::polymorphic_allocator<int>(&arena) };
+    EXPECT_THROW(target = std::move(source), std::bad_alloc);
+}
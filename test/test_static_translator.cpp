@@ -0,0 +1,126 @@
+#include <gtest.h>
+#include <stdexcept>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include "static_translator.h"
+#include "translator.h"
+
+using namespace translator::literals;
+
+// Вычисляются компилятором: ошибка в выражении не дала бы собрать тест
+static_assert("2+3*4"_calc == 14.0);
+static_assert("-(2+3)*4"_calc == -20.0);
+static_assert("8/2/2"_calc == 2.0);
+static_assert("--(5) + -(-2)"_calc == 7.0);
+static_assert(".5 + .25"_calc == 0.75);
+static_assert("1.5e3 - 2.5E-1"_calc == 1499.75);
+static_assert("2^3^2 - -2^2"_calc == 516.0);
+
+// Большие порядки и длинные мантиссы переводятся точно, как strtod
+static_assert("1.7976931348623157e308"_calc == 1.7976931348623157e308);
+static_assert("2.2250738585072014e-308"_calc == 2.2250738585072014e-308);
+static_assert("4.9406564584124654e-324"_calc == 4.9406564584124654e-324);
+static_assert("1e23"_calc == 1e23);
+static_assert("9007199254740993"_calc == 9007199254740992.0);
+static_assert("1e400"_calc == std::numeric_limits<double>::infinity());
+static_assert("1e-400"_calc == 0.0);
+
+// Вычисленный показатель: на этапе компиляции допустима только точная степень ("1.1^(30+0)" не скомпилируется)
+static_assert("2^(1+2)"_calc == 8.0);
+static_assert("2^-2 + 0.5^(5-1)"_calc == 0.3125);
+
+constexpr auto kCompiledPolynomial = compileStatic("((2+3)*(4+5)-6)/(1+2)");
+static_assert(kCompiledPolynomial.length == 13);
+static_assert(kCompiledPolynomial.evaluate() == 13.0);
+
+TEST(StaticTranslatorTest, MatchesRuntimeTranslator) {
+    const char* expressions[] = {
+        "2+2", "10-3", "6*7", "7/2", "2*3+4", "8/2*3", "8/(2*3)", "5+2*3-4/2",
+        "((((1+2)*3)+4)/5)", "\t(\n1 + 2\t)\n* 3\r", "---2", "6/-3", "-6/-3",
+        "0.1+0.2", "123456.789 + 0.001", "-(.5 + .25)", "3 + 4 * 2 / (1 - 5)",
+        "10/(2+3) + 7*(1-3)", "1+2+3+4+5+6+7+8+9+10", "-(-(-(-(-1))))", "1e5*2.5e-3",
+        "0.000123456789", "12345678901234567890", "3.14159265358979323846",
+        "1.1^7 - 2^(1+1) + 2^0.5"
+    };
+    Translator calc;
+    for (const char* expression : expressions) {
+        EXPECT_EQ(StaticTranslator::calculate(expression), calc.calculate(expression)) << expression;
+    }
+}
+
+TEST(StaticTranslatorTest, NumbersMatchRuntimeLexer) {
+    const char* numbers[] = {
+        "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308", "2.2250738585072011e-308",
+        "2.2250738585072014e-308", "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+        "1e23", "8.98846567431158e307", "9007199254740993", "9007199254740993.0000000000000000000001",
+        "123456789012345678901234567890e-50", "0.000000000000000000000000000001e-290", "1e-400", "1e400",
+        "7.2057594037927933e16", "2.0000000000000002220446049250313080847263336181640625",
+        "2.0000000000000002220446049250313080847263336181640624"
+    };
+    Translator calc;
+    for (const char* number : numbers) {
+        const double compiled = StaticTranslator::calculate(number);
+        const double runtime = calc.calculate(number);
+        EXPECT_EQ(std::memcmp(&compiled, &runtime, sizeof(double)), 0) << number;
+    }
+    // Больше 800 значащих цифр: хвост влияет только на направление округления
+    for (const std::string& number : { "0." + std::string(1000, '3'), std::string(900, '9'),
+                                       "9007199254740993" + std::string(900, '0') + "1e-900" }) {
+        const double compiled = StaticTranslator::calculate<4>(number);
+        const double runtime = calc.calculate(number);
+        EXPECT_EQ(std::memcmp(&compiled, &runtime, sizeof(double)), 0) << number;
+    }
+
+    // Случайные значения во всем диапазоне порядков: кратчайшая запись, 17 и 25 значащих цифр
+    std::mt19937_64 generator(28);
+    for (int i = 0; i < 3000; ++i) {
+        std::uint64_t bits = generator() & ~(std::uint64_t{ 1 } << 63);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (!std::isfinite(value)) continue;
+        char text[64];
+        for (const char* format : { "%.17g", "%.25e", "%.6e" }) {
+            std::snprintf(text, sizeof(text), format, value);
+            const double compiled = StaticTranslator::calculate(text);
+            const double runtime = calc.calculate(text);
+            ASSERT_EQ(std::memcmp(&compiled, &runtime, sizeof(double)), 0) << text;
+        }
+    }
+}
+
+TEST(StaticTranslatorTest, NonLiteralExponentsMatchRuntime) {
+    // Значения посчитаны компилятором; Translator для вычисленного показателя вызывает pow
+    constexpr double compiled[] = { "2^(1+2)"_calc, "2^3^2"_calc, "(-3)^(2*2)"_calc, "2^-3"_calc,
+                                    "1.5^(2*5)"_calc, "(0-0.5)^(3+0)"_calc, "10^(4*5)"_calc, "2^(0-40)"_calc };
+    const char* expressions[] = { "2^(1+2)", "2^3^2", "(-3)^(2*2)", "2^-3",
+                                  "1.5^(2*5)", "(0-0.5)^(3+0)", "10^(4*5)", "2^(0-40)" };
+    Translator calc;
+    for (std::size_t i = 0; i < std::size(expressions); ++i) {
+        const double runtime = calc.calculate(expressions[i]);
+        EXPECT_EQ(std::memcmp(&compiled[i], &runtime, sizeof(double)), 0) << expressions[i];
+        // Тот же код StaticEval вне constant evaluation тоже идет через pow
+        EXPECT_EQ(StaticTranslator::calculate(expressions[i]), runtime) << expressions[i];
+    }
+    EXPECT_EQ(StaticTranslator::calculate("1.1^(30+0)"), calc.calculate("1.1^(30+0)"));
+}
+
+TEST(StaticTranslatorTest, RuntimeErrorsMatch) {
+    const char* invalid[] = { "", "   ", "2 & 3", "1..2", "..2", "5**2", "2+3-", "+3",
+                              "2 3", "1(2+3)", "()", "(2+3", "2+3)", "(-)", "5/0", "5/(3-3)" };
+    for (const char* expression : invalid) {
+        EXPECT_THROW(StaticTranslator::calculate(expression), std::runtime_error) << expression;
+    }
+}
+
+TEST(StaticTranslatorTest, CapacityExceeded) {
+    std::string longExpression = "1";
+    for (int i = 0; i < 200; ++i) longExpression += "+1";
+    EXPECT_THROW(StaticTranslator::calculate<16>(longExpression), std::runtime_error);
+    EXPECT_DOUBLE_EQ(StaticTranslator::calculate<512>(longExpression), 201.0);
+}
@@ -0,0 +1,50 @@
+#include <gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "translator.h"
+#include "threaded.h"
+
+static const char* const kExpressions[] = {
+    "x", "7", "-x", "a*x+b", "a-x-3", "-a*b", "-a*-b-c", "2*-x", "x/4+x/100", "a/b",
+    "x^2+x^-1+x^0.5", "sqrt(a*a+b*b)", "max(a, b)-min(x, 3)", "pow(a, 2.5)*abs(-b)",
+    "((((a+1)*2-b)*3+x)*4-a)*5", "a-(b-(x-(a-(b-1))))"
+};
+
+TEST(ThreadedEvalTest, MatchesStackMachineBitForBit) {
+    Translator calc;
+    std::vector<double> values = { 1.75, -0.5, 3.25 };
+    ThreadedEval threaded;
+    for (const char* expression : kExpressions) {
+        Program program = calc.compile(expression, OptimizerOptions{});
+        std::vector<double> arguments(values.begin(), values.begin() + program.variables.size());
+        const double expected = calc.calculate(program, arguments);
+        for (bool superinstructions : { false, true }) {
+            ThreadedProgram compiled = ThreadedEval::compile(program, superinstructions);
+            EXPECT_EQ(threaded.evaluate(compiled, arguments.data()), expected) << expression;
+            EXPECT_EQ(threaded.evaluateSwitch(compiled, arguments.data()), expected) << expression;
+        }
+    }
+}
+
+TEST(ThreadedEvalTest, SuperinstructionsShortenCode) {
+    Program program = Translator().compile("-a*b+c*2-x");
+    ThreadedProgram plain = ThreadedEval::compile(program, false);
+    ThreadedProgram fused = ThreadedEval::compile(program, true);
+    EXPECT_EQ(plain.code.size(), program.code.size() + 1);
+    EXPECT_LT(fused.code.size(), plain.code.size());
+    EXPECT_LE(fused.stackDepth, plain.stackDepth);
+    EXPECT_EQ(fused.code.back().op, ThreadedOp::Return);
+}
+
+TEST(ThreadedEvalTest, ReportsErrors) {
+    Translator calc;
+    ThreadedProgram program = calc.compileThreaded("a/b");
+    EXPECT_EQ(calc.calculate(program, { 3.0, 4.0 }), 0.75);
+    EXPECT_THROW(calc.calculate(program, { 1.0, 0.0 }), std::runtime_error);
+    EXPECT_THROW(calc.calculate(program, { 1.0 }), std::runtime_error);
+    EXPECT_THROW(calc.calculate(calc.compileThreaded("log(x)"), { 0.0 }), std::runtime_error);
+    // После исключения вычислитель остается рабочим
+    EXPECT_EQ(calc.calculate(program, { 1.0, 2.0 }), 0.5);
+}
@@ -2,9 +2,33 @@
 #include <stdexcept>
 #include <cmath>
 #include <string>
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include <atomic>
 
 #include "translator.h"
 
+// Счетчик выделений памяти для проверки переиспользования рабочих буферов.
+// Замена operator new действует на весь translator_tests, где память выделяют и другие потоки, поэтому счетчик атомарный
+static std::atomic<std::size_t> g_allocationCount{ 0 };
+
+void* operator new(std::size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+// Пара malloc/free здесь намеренная: после встраивания GCC видит free на указателе от new и предупреждает
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
 class TranslatorTest : public ::testing::Test {
 protected:
     Translator calc;
@@ -191,4 +215,175 @@ TEST_F(TranslatorTest, Edge_DeepNestingUnary) {
 
 TEST_F(TranslatorTest, Edge_ManySpacesEverywhere) {
     AssertNear(calc.calculate("  (  (  2  +  3 )  * (  4 + 5 )  -  6 )  /  ( 1 + 2 )  "), 13.0);
-}
\ No newline at end of file
+}
+
+TEST_F(TranslatorTest, Scratch_NoAllocationsWhenWarm) {
+    const std::string expression = "((2+3)*(4+5)-6)/(1+2) + 1+2+3+4+5+6+7+8+9+10 - -(-(.5))";
+    AssertNear(calc.calculate(expression), 13.0 + 55.0 - 0.5);
+
+    std::size_t before = g_allocationCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < 100; ++i) calc.calculate(expression);
+    EXPECT_EQ(g_allocationCount.load(std::memory_order_relaxed), before);
+}
+
+TEST_F(TranslatorTest, Scratch_ReleasedAboveLimit) {
+    calc.setScratchLimit(8);
+    std::string longExpression = "1";
+    for (int i = 0; i < 1000; ++i) longExpression += "+1";
+    AssertNear(calc.calculate(longExpression), 1001.0);
+    // Буферы выше порога освобождаются, поэтому следующий вызов выделяет память заново
+    std::size_t before = g_allocationCount.load(std::memory_order_relaxed);
+    AssertNear(calc.calculate("2*(3+4)"), 14.0);
+    EXPECT_GT(g_allocationCount.load(std::memory_order_relaxed), before);
+}
+
+TEST_F(TranslatorTest, Variables_CompileOnceEvaluateMany) {
+    Program program = calc.compile("rate * (base + x_1) - rate / 2");
+    ASSERT_EQ(program.variables.size(), 3u);
+    EXPECT_EQ(program.variables[0], "rate");
+    EXPECT_EQ(program.variables[2], "x_1");
+    AssertNear(calc.calculate(program, { 2.0, 10.0, 5.0 }), 29.0);
+    AssertNear(calc.calculate(program, { 4.0, 1.0, 1.0 }), 6.0);
+    EXPECT_THROW(calc.calculate(program, { 1.0 }), std::runtime_error);
+    EXPECT_THROW(calc.calculate(calc.compile("1 / x"), { 0.0 }), std::runtime_error);
+}
+
+TEST_F(TranslatorTest, Variables_UnboundInCalculate) {
+    EXPECT_THROW(calc.calculate("x + 1"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("2 x"), std::runtime_error);
+    AssertNear(calc.calculate(calc.compile("-x-1"), { 3.0 }), -4.0);
+}
+
+TEST_F(TranslatorTest, Functions_Basic) {
+    AssertNear(calc.calculate("sqrt(16)"), 4.0);
+    AssertNear(calc.calculate("exp(0) + log(1)"), 1.0);
+    AssertNear(calc.calculate("pow(2, 10)"), 1024.0);
+    AssertNear(calc.calculate("sin(0) + cos(0)"), 1.0);
+    AssertNear(calc.calculate("min(3, -2) * max(3, -2)"), -6.0);
+    AssertNear(calc.calculate("abs(-7.5)"), 7.5);
+}
+
+TEST_F(TranslatorTest, Functions_NestingAndExpressions) {
+    AssertNear(calc.calculate("max(1, -2) - -sqrt(2*8) / pow(2, 1+1)"), 2.0);
+    AssertNear(calc.calculate("min(max(1, 2), max(3, abs(-4)))"), 2.0);
+    AssertNear(calc.calculate("2 * sqrt ( 9 ) + pow(-2, 3)"), -2.0);
+    AssertNear(calc.calculate("max(-1, -(2+3)*4)"), -1.0);
+}
+
+TEST_F(TranslatorTest, Functions_Errors) {
+    EXPECT_THROW(calc.calculate("foo(1)"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("sqrt(1, 2)"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("pow(2)"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("sqrt()"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("max(1,)"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("(1, 2)"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("1, 2"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("sqrt(-1)"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("log(0)"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("sqrt(4"), std::runtime_error);
+}
+
+TEST_F(TranslatorTest, Functions_BatchMatchesScalar) {
+    Program program = calc.compile("sqrt(abs(x)) + exp(-x*x) * log(y) - pow(y, 0.5) / max(x, 1) + min(sin(x), cos(y)) + x^3 - y^-2 + 1.01^x");
+    const std::size_t rows = 1000;
+    std::vector<double> xs(rows), ys(rows), results(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        xs[i] = static_cast<double>(i) * 0.013 - 6.0;
+        ys[i] = static_cast<double>(i) * 0.7 + 0.5;
+    }
+    calc.calculateBatch(program, { xs.data(), ys.data() }, rows, results.data());
+    for (std::size_t i = 0; i < rows; ++i) {
+        EXPECT_EQ(results[i], calc.calculate(program, { xs[i], ys[i] })) << i;
+    }
+
+    ys[rows - 1] = -1.0;
+    EXPECT_THROW(calc.calculateBatch(program, { xs.data(), ys.data() }, rows, results.data()), std::runtime_error);
+}
+
+TEST_F(TranslatorTest, Power_PrecedenceAndAssociativity) {
+    AssertNear(calc.calculate("2^10"), 1024.0);
+    AssertNear(calc.calculate("2^3^2"), 512.0);
+    AssertNear(calc.calculate("-2^2"), -4.0);
+    AssertNear(calc.calculate("(-2)^2"), 4.0);
+    AssertNear(calc.calculate("2^-2"), 0.25);
+    AssertNear(calc.calculate("3*2^2+1"), 13.0);
+    AssertNear(calc.calculate("2^0.5"), std::sqrt(2.0));
+    AssertNear(calc.calculate("4^(1/2)"), 2.0);
+    EXPECT_THROW(calc.calculate("2^"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("^2"), std::runtime_error);
+    EXPECT_THROW(calc.calculate("(-8)^(1/3)"), std::runtime_error);
+}
+
+TEST_F(TranslatorTest, Power_IntegerExponentFastPath) {
+    Program program = calc.compile("x^5 - x^-3 + x^y");
+    std::size_t powerInt = 0, power = 0;
+    for (const Instruction& instruction : program.code) {
+        if (instruction.opCode == OpCode::PowerInt) powerInt++;
+        if (instruction.opCode == OpCode::Power) power++;
+    }
+    EXPECT_EQ(powerInt, 1u);   // x^-3: показатель - унарный минус, а не литерал
+    EXPECT_EQ(power, 2u);
+
+    for (double x : { 0.5, 1.1, -3.0, 7.25 }) {
+        double expected = calc.calculate("(" + std::to_string(x) + ")^5 - (" + std::to_string(x) + ")^-3 + ("
+            + std::to_string(x) + ")^2");
+        EXPECT_EQ(calc.calculate(program, { x, 2.0 }), expected) << x;
+    }
+    AssertNear(calc.calculate(calc.compile("x^64"), { 1.0 }), 1.0);
+    EXPECT_EQ(calc.calculate(calc.compile("x^-1"), { 0.0 }), HUGE_VAL);
+}
+
+// Код превышенного лимита или 0, если выражение вычислилось
+static int limitCode(Translator& translator, const std::string& expression) {
+    try {
+        translator.calculate(expression);
+    }
+    catch (const LimitExceeded& e) {
+        return static_cast<int>(e.kind());
+    }
+    catch (const std::runtime_error&) {
+    }
+    return 0;
+}
+
+TEST_F(TranslatorTest, Limits_DistinctCodes) {
+    const Program deepProgram = calc.compile("x*(x*(x*(x*(x*(x*(x*x))))))");
+    EvaluationLimits limits;
+    limits.maxInputBytes = 64;
+    limits.maxTokens = 12;
+    limits.maxNesting = 3;
+    limits.maxStackDepth = 6;
+    calc.setLimits(limits);
+
+    EXPECT_EQ(limitCode(calc, "((1+2)*3)-4"), 0);
+    EXPECT_EQ(limitCode(calc, std::string(65, '1')), static_cast<int>(LimitKind::InputBytes));
+    EXPECT_EQ(limitCode(calc, "1+1+1+1+1+1+1"), static_cast<int>(LimitKind::Tokens));
+    EXPECT_EQ(limitCode(calc, "((((1))))"), static_cast<int>(LimitKind::Nesting));
+    EXPECT_EQ(limitCode(calc, "-------1"), static_cast<int>(LimitKind::StackDepth));
+    EXPECT_THROW(calc.calculate(deepProgram, { 2.0 }), LimitExceeded);
+
+    try {
+        calc.calculate("((((1))))");
+        FAIL();
+    }
+    catch (const LimitExceeded& e) {
+        EXPECT_STREQ(e.what(), "Limit error: nesting deeper than 3");
+        EXPECT_EQ(e.limit(), 3u);
+    }
+}
+
+TEST_F(TranslatorTest, Limits_StopPathologicalInputEarly) {
+    // Без лимитов ввод разбирается целиком
+    std::string deep(100000, '(');
+    deep += "1";
+    deep += std::string(100000, ')');
+    AssertNear(calc.calculate(deep), 1.0);
+
+    calc.setLimits(EvaluationLimits::serverDefaults());
+    EXPECT_EQ(limitCode(calc, deep), static_cast<int>(LimitKind::Nesting));
+    EXPECT_EQ(limitCode(calc, std::string(2 << 20, ' ')), static_cast<int>(LimitKind::InputBytes));
+    std::string longSum = "1";
+    for (int i = 0; i < 200000; ++i) longSum += "+1";
+    EXPECT_EQ(limitCode(calc, longSum), static_cast<int>(LimitKind::Tokens));
+    AssertNear(calc.calculate("-(-(-(-1)))"), 1.0);
+}